@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Compare the available flate backends on a corpus of PDFs.
+
+For each backend, measures the time to decode every flate stream in the corpus
+with read_bytes(), and the time and output size of saving each PDF with all
+streams recompressed. By default the corpus is the test suite's resources.
+
+Usage: python bin/benchmark_flate.py [PDF or directory ...] [--repeat N]
+"""
+
+from __future__ import annotations
+
+import argparse
+import time
+from io import BytesIO
+from pathlib import Path
+
+import pikepdf
+from pikepdf.settings import get_flate_backends, set_flate_backend
+
+DEFAULT_CORPUS = Path(__file__).parent.parent / 'tests' / 'resources'
+
+
+def find_pdfs(paths: list[Path]) -> list[Path]:
+    pdfs = []
+    for path in paths:
+        if path.is_dir():
+            pdfs.extend(sorted(path.rglob('*.pdf')))
+        else:
+            pdfs.append(path)
+    return pdfs
+
+
+def load_corpus(pdfs: list[Path]) -> list[tuple[Path, bytes]]:
+    """Read the PDFs that open without a password into memory."""
+    corpus = []
+    for path in pdfs:
+        data = path.read_bytes()
+        try:
+            with pikepdf.open(BytesIO(data)):
+                pass
+        except (pikepdf.PdfError, pikepdf.PasswordError):
+            continue
+        corpus.append((path, data))
+    return corpus
+
+
+def is_flate(stream: pikepdf.Stream) -> bool:
+    filters = stream.get('/Filter')
+    if isinstance(filters, pikepdf.Array):
+        return any(f in ('/FlateDecode', '/Fl') for f in filters)
+    return filters in ('/FlateDecode', '/Fl')
+
+
+def time_decode(corpus: list[tuple[Path, bytes]]) -> tuple[float, int]:
+    elapsed = 0.0
+    nbytes = 0
+    for _path, data in corpus:
+        with pikepdf.open(BytesIO(data)) as pdf:
+            streams = [
+                obj
+                for obj in pdf.objects
+                if isinstance(obj, pikepdf.Stream) and is_flate(obj)
+            ]
+            start = time.perf_counter()
+            for stream in streams:
+                try:
+                    nbytes += len(stream.read_bytes())
+                except pikepdf.PdfError:
+                    pass
+            elapsed += time.perf_counter() - start
+    return elapsed, nbytes
+
+
+def time_save(corpus: list[tuple[Path, bytes]]) -> tuple[float, int]:
+    elapsed = 0.0
+    nbytes = 0
+    for _path, data in corpus:
+        with pikepdf.open(BytesIO(data)) as pdf:
+            output = BytesIO()
+            start = time.perf_counter()
+            pdf.save(output, recompress_flate=True, deterministic_id=True)
+            elapsed += time.perf_counter() - start
+            nbytes += len(output.getvalue())
+    return elapsed, nbytes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('paths', nargs='*', type=Path, default=[DEFAULT_CORPUS])
+    parser.add_argument('--repeat', type=int, default=3, help="take the best of N")
+    args = parser.parse_args()
+
+    corpus = load_corpus(find_pdfs(args.paths))
+    print(f"{len(corpus)} PDFs, backends: {', '.join(get_flate_backends())}")
+    print(
+        f"{'backend':<12} {'decode s':>10} {'decoded MB':>11} "
+        f"{'save s':>10} {'saved MB':>10}"
+    )
+    previous = None
+    try:
+        for backend in get_flate_backends():
+            previous_backend = set_flate_backend(backend)
+            if previous is None:
+                previous = previous_backend
+            decode = min(time_decode(corpus) for _ in range(args.repeat))
+            save = min(time_save(corpus) for _ in range(args.repeat))
+            print(
+                f"{backend:<12} {decode[0]:>10.3f} {decode[1] / 1e6:>11.2f} "
+                f"{save[0]:>10.3f} {save[1] / 1e6:>10.2f}"
+            )
+    finally:
+        if previous is not None:
+            set_flate_backend(previous)
+
+
+if __name__ == '__main__':
+    main()
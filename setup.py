@@ -24,6 +24,13 @@ extra_library_dirs = []
 qpdf_source_tree = environ.get('QPDF_SOURCE_TREE', '')
 qpdf_build_libdir = environ.get('QPDF_BUILD_LIBDIR', '')
 qpdf_future = environ.get('QPDF_FUTURE', '')
+# Build with libdeflate, for pikepdf.settings.set_flate_backend('libdeflate')
+with_libdeflate = environ.get('PIKEPDF_WITH_LIBDEFLATE', '')
+# Build with libjbig2dec, to decode JBIG2 in process (pikepdf.jbig2.NativeJBIG2Decoder)
+with_jbig2dec = environ.get('PIKEPDF_WITH_JBIG2DEC', '')
+# Link zlib, to compress streams at per-stream levels (pikepdf.CompressionPolicy).
+# qpdf's Windows releases do not include zlib's headers.
+with_zlib = environ.get('PIKEPDF_WITH_ZLIB', '' if sys.platform == 'win32' else '1')
 
 if not qpdf_source_tree and exists('../qpdf'):
     print("Using local qpdf source tree at '../qpdf'")
@@ -76,8 +83,18 @@ for extra_path in chain([qpdf_source_tree], extra_includes, extra_library_dirs):
         raise FileNotFoundError(extra_path)
 
 macros = []
+libraries = ['qpdf']
 if qpdf_future:
     macros.append(('QPDF_FUTURE', 'True'))
+if with_libdeflate:
+    macros.append(('PIKEPDF_WITH_LIBDEFLATE', '1'))
+    libraries.append('deflate')
+if with_jbig2dec:
+    macros.append(('PIKEPDF_WITH_JBIG2DEC', '1'))
+    libraries.append('jbig2dec')
+if with_zlib not in ('', '0'):
+    macros.append(('PIKEPDF_WITH_ZLIB', '1'))
+    libraries.append('z')
 # Use cast because mypy has trouble seeing Pybind11Extension is a subclass of
 # Extension.
 extmodule: Extension = cast(
@@ -92,7 +109,7 @@ extmodule: Extension = cast(
         ],
         define_macros=macros,
         library_dirs=[*extra_library_dirs],
-        libraries=['qpdf'],
+        libraries=libraries,
         cxx_std=20,
     ),
 )
@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <cstdio>
+#include <cstring>
+
+#include <qpdf/Buffer.hh>
+#include <qpdf/BufferInputSource.hh>
+#include <qpdf/Constants.h>
+#include <qpdf/DLL.h>
+#include <qpdf/InputSource.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QUtil.hh>
+#include <qpdf/Types.h>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "pikepdf.h"
+#include "utils.h"
+
+// An InputSource over the memory of any Python object that supports the buffer
+// protocol: bytes, bytearray, memoryview, mmap, numpy arrays and so on. As with
+// MmapInputSource, we wrap the memory in a BufferInputSource that does not own it,
+// so opening does not copy the data.
+//
+// We hold a buffer export (Py_buffer) for as long as the input source exists, which
+// keeps the object alive and, for resizable objects like bytearray, prevents it from
+// being resized underneath us. Objects must be C-contiguous.
+
+// GIL usage:
+// The GIL must be held while this class is constructed, by the constructor's caller,
+// and the destructor acquires it to release the buffer export. All other methods
+// only touch memory we already hold an export for, so they do not need the GIL.
+class PythonBufferInputSource : public InputSource {
+public:
+    PythonBufferInputSource(const py::object &obj, const std::string &description)
+        : InputSource()
+    {
+        py::gil_scoped_acquire acquire; // GIL must be held anyway, issue #295
+        this->obj = obj;
+
+        if (PyObject_GetBuffer(this->obj.ptr(), &this->view, PyBUF_SIMPLE) != 0)
+            throw py::error_already_set();
+        this->have_view = true;
+
+        this->buffer = std::make_unique<Buffer>(
+            static_cast<unsigned char *>(this->view.buf),
+            static_cast<size_t>(this->view.len));
+        this->bis = std::make_unique<BufferInputSource>(description,
+            this->buffer.get(),
+            false // own_memory=false
+        );
+    }
+    virtual ~PythonBufferInputSource()
+    {
+        py::gil_scoped_acquire acquire;
+        this->bis.reset();
+        this->buffer.reset();
+        if (this->have_view) {
+            PyBuffer_Release(&this->view);
+            this->have_view = false;
+        }
+    }
+    // LCOV_EXCL_START
+    PythonBufferInputSource(const PythonBufferInputSource &) = delete;
+    PythonBufferInputSource &operator=(const PythonBufferInputSource &) = delete;
+    PythonBufferInputSource(PythonBufferInputSource &&) = delete;
+    PythonBufferInputSource &operator=(PythonBufferInputSource &&) = delete;
+    // LCOV_EXCL_STOP
+
+    std::string const &getName() const override { return this->bis->getName(); }
+
+    qpdf_offset_t tell() override
+    {
+        auto result = this->bis->tell();
+        this->last_offset = this->bis->getLastOffset();
+        return result;
+    }
+
+    void seek(qpdf_offset_t offset, int whence) override
+    {
+        this->bis->seek(offset, whence);
+        this->last_offset = this->bis->getLastOffset();
+    }
+
+    // LCOV_EXCL_START
+    void rewind() override
+    {
+        // qpdf never seems to use this but still requires
+        this->bis->rewind();
+        this->last_offset = this->bis->getLastOffset();
+    }
+    // LCOV_EXCL_STOP
+
+    size_t read(char *buffer, size_t length) override
+    {
+        auto result = this->bis->read(buffer, length);
+        this->last_offset = this->bis->getLastOffset();
+        return result;
+    }
+
+    void unreadCh(char ch) override
+    {
+        this->bis->unreadCh(ch);
+        this->last_offset = this->bis->getLastOffset();
+    }
+
+    qpdf_offset_t findAndSkipNextEOL() override
+    {
+        auto result = this->bis->findAndSkipNextEOL();
+        this->last_offset = this->bis->getLastOffset();
+        return result;
+    }
+
+private:
+    py::object obj;
+    Py_buffer view{};
+    bool have_view = false;
+    std::unique_ptr<Buffer> buffer;
+    std::unique_ptr<BufferInputSource> bis;
+};
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+// Thrown when an operation stops because its CancellationToken was cancelled or
+// its time budget ran out. Becomes pikepdf.OperationCancelledError in Python.
+class OperationCancelled : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Asks a long-running operation to stop. The operation calls check() at points
+// where it can safely stop, such as between objects or output chunks, and check()
+// throws OperationCancelled once cancel() has been called from any thread or the
+// optional deadline has passed. Checks are cheap and never need the GIL.
+class CancellationToken {
+public:
+    using clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;
+    explicit CancellationToken(std::optional<double> timeout)
+    {
+        if (timeout) {
+            if (*timeout < 0)
+                throw std::invalid_argument("timeout must not be negative");
+            this->deadline = clock::now() +
+                             std::chrono::duration_cast<clock::duration>(
+                                 std::chrono::duration<double>(*timeout));
+        }
+    }
+    CancellationToken(const CancellationToken &) = delete;
+    CancellationToken &operator=(const CancellationToken &) = delete;
+
+    void cancel() { this->cancelled_.store(true, std::memory_order_relaxed); }
+
+    bool cancelled() const
+    {
+        return this->cancelled_.load(std::memory_order_relaxed) || this->expired();
+    }
+
+    bool expired() const { return this->deadline && clock::now() >= *this->deadline; }
+
+    // Seconds until the deadline, or nullopt if there is none
+    std::optional<double> remaining() const
+    {
+        if (!this->deadline)
+            return std::nullopt;
+        std::chrono::duration<double> left = *this->deadline - clock::now();
+        return std::max(left.count(), 0.0);
+    }
+
+    void check() const
+    {
+        if (this->cancelled_.load(std::memory_order_relaxed))
+            throw OperationCancelled("operation cancelled");
+        if (this->expired())
+            throw OperationCancelled("operation cancelled: time budget exceeded");
+    }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    std::optional<clock::time_point> deadline;
+};
@@ -0,0 +1,355 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+// Decoding many streams at once on worker threads.
+//
+// QPDF objects are not thread-safe, but separate QPDF objects may be used from
+// separate threads. So each stream's raw data is read on the calling thread, and
+// the stream is then recreated in a scratch QPDF of its own on a worker, where it
+// is decoded. Streams that cannot be detached this way are decoded on the calling
+// thread afterwards.
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <qpdf/Pl_Discard.hh>
+#include <qpdf/Pl_String.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+#include "jbig2dec.h"
+#include "pikepdf.h"
+#include "pipeline.h"
+#include "progress.h"
+#include "threadpool.h"
+
+namespace {
+
+struct StreamFailure {
+    QPDFObjGen og;
+    std::string filter;
+    std::string error;
+};
+
+// A stream's raw data and decoding parameters, detached from its QPDF
+struct DetachedStream {
+    std::string raw;
+    std::string filter;
+    std::string decode_parms;
+    bool unfiltered = false;
+};
+
+constexpr char const *undecodable = "stream data could not be decoded";
+constexpr char const *unfilterable =
+    "stream data cannot be decoded at this decode level";
+
+bool uses_filter(QPDFObjectHandle filter, std::string const &name)
+{
+    if (filter.isNameAndEquals(name))
+        return true;
+    if (filter.isArray())
+        for (auto const &item : filter.getArrayAsVector())
+            if (item.isNameAndEquals(name))
+                return true;
+    return false;
+}
+
+bool has_indirect_items(QPDFObjectHandle oh)
+{
+    if (oh.isArray()) {
+        for (auto const &item : oh.getArrayAsVector())
+            if (item.isIndirect() || has_indirect_items(item))
+                return true;
+    } else if (oh.isDictionary()) {
+        for (auto const &[key, item] : oh.getDictAsMap())
+            if (item.isIndirect() || has_indirect_items(item))
+                return true;
+    }
+    return false;
+}
+
+// Copy out the decoding parameters of a stream, unless it must be decoded in
+// place: JBIG2 streams, unless libjbig2dec is in use, because the decoder calls
+// into Python, and streams whose parameters refer to other objects, such as
+// /JBIG2Globals streams. Does not read the data.
+bool detach_parameters(QPDFObjectHandle &stream, DetachedStream &detached)
+{
+    auto dict = stream.getDict();
+    auto filter = dict.getKey("/Filter");
+    if (uses_filter(filter, "/JBIG2Decode") && !jbig2_native_decoding())
+        return false;
+    try {
+        auto decode_parms = dict.getKey("/DecodeParms");
+        if (has_indirect_items(filter) || has_indirect_items(decode_parms))
+            return false;
+        detached.filter = filter.unparseResolved();
+        detached.decode_parms = decode_parms.unparseResolved();
+        detached.unfiltered =
+            filter.isNull() || (filter.isArray() && filter.getArrayNItems() == 0);
+    } catch (std::exception &) {
+        return false;
+    }
+    return true;
+}
+
+// Read a stream's raw data. Throws if it cannot be read.
+void read_raw(QPDFObjectHandle &stream, std::string &raw)
+{
+    Pl_String pl_raw("decode pool raw", nullptr, raw);
+    if (!stream.pipeStreamData(&pl_raw, nullptr, 0, qpdf_dl_none, true, false))
+        throw std::runtime_error("stream data could not be read");
+}
+
+// Decode a detached stream, into out or else discarding the result. Safe to run on
+// a worker. Returns the first error, if any. If must_filter, it is an error for
+// the stream's filters not to be supported at this level, as for read_bytes(); a
+// stream with no filters is its own decoded data at every level.
+std::optional<std::string> decode_detached(DetachedStream const &detached,
+    qpdf_stream_decode_level_e level,
+    Pipeline *out,
+    bool must_filter)
+{
+    try {
+        auto scratch = QPDF::create();
+        scratch->emptyPDF();
+        scratch->setSuppressWarnings(true);
+        auto stream = QPDFObjectHandle::newStream(scratch.get());
+        stream.replaceStreamData(detached.raw,
+            QPDFObjectHandle::parse(detached.filter),
+            QPDFObjectHandle::parse(detached.decode_parms));
+
+        Pl_Discard discard;
+        bool filtered = false;
+        bool ok = stream.pipeStreamData(
+            out ? out : &discard, &filtered, 0, level, false, false);
+        auto warnings = scratch->getWarnings();
+        if (!warnings.empty())
+            return warnings.front().getMessageDetail();
+        if (!ok)
+            return undecodable;
+        if (must_filter && !filtered && !detached.unfiltered)
+            return unfilterable;
+    } catch (std::exception &e) {
+        return e.what();
+    }
+    return std::nullopt;
+}
+
+py::object dependency_error_type()
+{
+    return py::module_::import("pikepdf._exceptions").attr("DependencyError");
+}
+
+// Read every stream's raw data on this thread, and decode it on the pool. Streams
+// that cannot be detached are returned for the caller.
+std::vector<QPDFObjectHandle> validate_detached(QPDF &q,
+    unsigned int threads,
+    std::shared_ptr<CancellationToken> token,
+    std::vector<StreamFailure> &failures)
+{
+    std::vector<QPDFObjectHandle> attached;
+    std::mutex failures_mutex;
+    auto add_failure = [&](QPDFObjGen og, std::string filter, std::string error) {
+        std::lock_guard<std::mutex> lock(failures_mutex);
+        failures.push_back({og, std::move(filter), std::move(error)});
+    };
+
+    WorkerPool pool(threads);
+    for (auto &oh : q.getAllObjects()) {
+        if (!oh.isStream())
+            continue;
+        if (token)
+            token->check();
+        auto type = oh.getDict().getKey("/Type");
+        if (type.isNameAndEquals("/XRef") || type.isNameAndEquals("/ObjStm"))
+            continue;
+
+        auto detached = std::make_shared<DetachedStream>();
+        if (!detach_parameters(oh, *detached)) {
+            attached.push_back(oh);
+            continue;
+        }
+        auto og = oh.getObjGen();
+        try {
+            read_raw(oh, detached->raw);
+        } catch (std::exception &e) {
+            add_failure(og, detached->filter, e.what());
+            continue;
+        }
+        pool.submit([detached, og, &add_failure]() {
+            if (auto error = decode_detached(*detached, qpdf_dl_all, nullptr, false))
+                add_failure(og, detached->filter, *error);
+        });
+    }
+    pool.wait();
+    return attached;
+}
+
+// The result of decoding one stream for read_streams
+struct ReadResult {
+    std::string data;
+    std::optional<std::string> error;
+    bool attached = false;
+};
+
+} // namespace
+
+py::list validate_streams(QPDF &q, int threads, py::object cancellation_token)
+{
+    auto token = get_cancellation_token(cancellation_token);
+    std::vector<StreamFailure> failures;
+    std::vector<QPDFObjectHandle> attached;
+    {
+        py::gil_scoped_release release;
+        attached =
+            validate_detached(q, WorkerPool::thread_count(threads), token, failures);
+    }
+
+    // The rest are decoded here with the GIL held, falling back as
+    // _decode_all_streams_and_discard does if no JBIG2 decoder is available, and
+    // retrying the stream that found the decoder missing at the lower level
+    bool specialized_available = true;
+    for (auto &stream : attached) {
+        if (token)
+            token->check();
+        auto og = stream.getObjGen();
+        auto filter = stream.getDict().getKey("/Filter").unparse();
+        for (bool retry = true; retry;) {
+            retry = false;
+            auto level = specialized_available ? qpdf_dl_all : qpdf_dl_generalized;
+            try {
+                Pl_Discard discard;
+                if (!stream.pipeStreamData(&discard, nullptr, 0, level, true, false))
+                    failures.push_back({og, filter, undecodable});
+            } catch (py::error_already_set &e) {
+                if (!specialized_available || !e.matches(dependency_error_type()))
+                    throw;
+                python_warning("pikepdf is missing some specialized decoders "
+                               "(probably jbig2dec) so not all stream contents can "
+                               "be tested.");
+                specialized_available = false;
+                retry = true;
+            } catch (std::exception &e) {
+                failures.push_back({og, filter, e.what()});
+            }
+        }
+    }
+
+    std::sort(failures.begin(), failures.end(), [](auto const &a, auto const &b) {
+        return a.og < b.og;
+    });
+    py::list result;
+    for (auto const &failure : failures) {
+        py::dict item;
+        item["objgen"] = py::make_tuple(failure.og.getObj(), failure.og.getGen());
+        item["filter"] = failure.filter;
+        item["error"] = failure.error;
+        result.append(item);
+    }
+    return result;
+}
+
+py::list read_streams(QPDF &q,
+    std::vector<QPDFObjectHandle> objects,
+    qpdf_stream_decode_level_e decode_level,
+    int threads)
+{
+    (void)q; // Streams may belong to any Pdf; all are read on this thread
+    std::vector<ReadResult> results(objects.size());
+    {
+        py::gil_scoped_release release;
+        WorkerPool pool(WorkerPool::thread_count(threads));
+        for (size_t i = 0; i < objects.size(); ++i) {
+            auto &stream = objects[i];
+            auto *result = &results[i];
+            if (!stream.isStream()) {
+                result->error = "object is not a stream";
+                continue;
+            }
+            auto detached = std::make_shared<DetachedStream>();
+            if (!detach_parameters(stream, *detached)) {
+                result->attached = true;
+                continue;
+            }
+            try {
+                read_raw(stream, detached->raw);
+            } catch (std::exception &e) {
+                result->error = e.what();
+                continue;
+            }
+            pool.submit([detached, result, decode_level]() {
+                Pl_String decoded("decode pool output", nullptr, result->data);
+                result->error =
+                    decode_detached(*detached, decode_level, &decoded, true);
+                if (result->error)
+                    result->data.clear();
+            });
+        }
+        pool.wait();
+    }
+
+    auto pdf_error = py::module_::import("pikepdf").attr("PdfError");
+    py::list output;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        auto &result = results[i];
+        if (result.attached) {
+            // Decoded in place, as read_bytes() would, with any exception kept
+            try {
+                auto buf = objects[i].getStreamData(decode_level);
+                output.append(
+                    py::bytes(reinterpret_cast<const char *>(buf->getBuffer()),
+                        buf->getSize()));
+            } catch (py::error_already_set &e) {
+                output.append(e.value());
+            } catch (std::exception &e) {
+                output.append(pdf_error(e.what()));
+            }
+            continue;
+        }
+        if (!objects[i].isStream()) {
+            auto type_error = py::reinterpret_borrow<py::object>(PyExc_TypeError);
+            output.append(type_error(*result.error));
+        } else if (result.error) {
+            auto og = objects[i].getObjGen().unparse(' ');
+            output.append(pdf_error("object " + og + ": " + *result.error));
+        } else {
+            output.append(py::bytes(result.data));
+            std::string().swap(result.data);
+        }
+    }
+    return output;
+}
+
+py::object detach_decoder(QPDFObjectHandle &stream, qpdf_stream_decode_level_e level)
+{
+    auto *owner = stream.getOwningQPDF();
+    auto filename = owner ? owner->getFilename() : std::string();
+    auto object = std::string("object ") + stream.getObjGen().unparse();
+
+    // With no pipeline, qpdf only reports whether it can decode at this level
+    if (!stream.pipeStreamData(nullptr, nullptr, 0, level, false, false))
+        throw QPDFExc(qpdf_e_damaged_pdf,
+            filename,
+            object,
+            0,
+            "open_decoded called on unfilterable stream");
+
+    auto detached = std::make_shared<DetachedStream>();
+    if (!detach_parameters(stream, *detached))
+        return py::none();
+    read_raw(stream, detached->raw);
+
+    return py::cpp_function(
+        [detached, level, filename, object](std::shared_ptr<OutputChunkQueue> queue) {
+            py::gil_scoped_release release;
+            Pl_ChunkQueueOutput output("open_decoded", queue);
+            if (auto error = decode_detached(*detached, level, &output, false))
+                throw QPDFExc(qpdf_e_damaged_pdf, filename, object, 0, *error);
+        });
+}
@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <exception>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <qpdf/Pl_Count.hh>
+#include <qpdf/Pl_Discard.hh>
+#include <qpdf/Pl_MD5.hh>
+#include <qpdf/Pl_String.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+#include "pikepdf.h"
+
+namespace {
+
+using CanonicalMap = std::map<QPDFObjGen, QPDFObjGen>;
+
+struct StreamEntry {
+    QPDFObjectHandle stream;
+    std::string digest; // Of the raw (still encoded) stream data
+    size_t size = 0;
+    std::string data; // Raw data, read only if another stream has the same digest
+};
+
+// Pipe a stream's raw data to pipeline. Returns false if it cannot be read.
+bool pipe_raw(QPDFObjectHandle &stream, Pipeline *pipeline)
+{
+    try {
+        return stream.pipeStreamData(pipeline, nullptr, 0, qpdf_dl_none, true, false);
+    } catch (std::exception &) {
+        return false;
+    }
+}
+
+// Unparse an object with sorted keys, so that dictionaries with the same content
+// compare equal, and with references to duplicates replaced by references to the
+// objects they will be merged into.
+void unparse_normalized(
+    QPDFObjectHandle oh, CanonicalMap const &canonical, std::string &out, bool top)
+{
+    if (oh.isIndirect() && !top) {
+        auto og = oh.getObjGen();
+        if (auto it = canonical.find(og); it != canonical.end())
+            og = it->second;
+        out += og.unparse(' ');
+        out += " R ";
+        return;
+    }
+    if (oh.isDictionary()) {
+        out += "<< ";
+        // getKeys() returns a sorted set
+        for (auto const &key : oh.getKeys()) {
+            // /Length is implied by the data, and may itself be indirect
+            if (top && key == "/Length")
+                continue;
+            auto value = oh.getKey(key);
+            if (value.isNull())
+                continue;
+            out += key;
+            out += ' ';
+            unparse_normalized(value, canonical, out, false);
+        }
+        out += ">> ";
+    } else if (oh.isArray()) {
+        out += "[ ";
+        for (auto const &item : oh.getArrayAsVector())
+            unparse_normalized(item, canonical, out, false);
+        out += "] ";
+    } else {
+        out += oh.unparse();
+        out += ' ';
+    }
+}
+
+std::string normalized_dict(QPDFObjectHandle stream, CanonicalMap const &canonical)
+{
+    std::string out;
+    unparse_normalized(stream.getDict(), canonical, out, true);
+    return out;
+}
+
+// Point direct references to duplicates in oh, and in any direct objects it
+// contains, at their canonical objects
+void rewrite_references(QPDF &q, QPDFObjectHandle oh, CanonicalMap const &canonical)
+{
+    auto replacement = [&](QPDFObjectHandle &item) -> std::optional<QPDFObjGen> {
+        if (!item.isIndirect())
+            return std::nullopt;
+        auto it = canonical.find(item.getObjGen());
+        if (it == canonical.end())
+            return std::nullopt;
+        return it->second;
+    };
+
+    if (oh.isDictionary()) {
+        for (auto const &key : oh.getKeys()) {
+            auto value = oh.getKey(key);
+            if (auto og = replacement(value))
+                oh.replaceKey(key, q.getObject(*og));
+            else if (!value.isIndirect())
+                rewrite_references(q, value, canonical);
+        }
+    } else if (oh.isArray()) {
+        int n = oh.getArrayNItems();
+        for (int i = 0; i < n; ++i) {
+            auto item = oh.getArrayItem(i);
+            if (auto og = replacement(item))
+                oh.setArrayItem(i, q.getObject(*og));
+            else if (!item.isIndirect())
+                rewrite_references(q, item, canonical);
+        }
+    }
+}
+
+struct DedupeResult {
+    size_t streams = 0;
+    size_t duplicates = 0;
+    size_t bytes_saved = 0;
+};
+
+DedupeResult deduplicate(QPDF &q)
+{
+    DedupeResult result;
+
+    // Hash the raw data as it is read, so that only one stream's data is in memory
+    // at a time
+    std::vector<std::unique_ptr<StreamEntry>> entries;
+    for (auto &oh : q.getAllObjects()) {
+        if (!oh.isStream())
+            continue;
+        auto type = oh.getDict().getKey("/Type");
+        // The writer regenerates or drops these
+        if (type.isNameAndEquals("/XRef") || type.isNameAndEquals("/ObjStm"))
+            continue;
+        Pl_Discard discard;
+        Pl_Count count("dedupe count", &discard);
+        Pl_MD5 md5("dedupe digest", &count);
+        if (!pipe_raw(oh, &md5))
+            continue;
+        auto entry = std::make_unique<StreamEntry>();
+        entry->stream = oh;
+        entry->digest = md5.getHexDigest();
+        entry->size = static_cast<size_t>(count.getCount());
+        entries.push_back(std::move(entry));
+    }
+    result.streams = entries.size();
+
+    // Candidate groups share a digest and size; the dictionaries are compared below
+    std::map<std::pair<std::string, size_t>, std::vector<StreamEntry *>> candidates;
+    for (auto &entry : entries)
+        candidates[{entry->digest, entry->size}].push_back(entry.get());
+    std::erase_if(candidates, [](auto const &item) { return item.second.size() < 2; });
+
+    // The digest is only a hint, so keep the data of candidates to compare
+    for (auto &[key, group] : candidates) {
+        std::erase_if(group, [](StreamEntry *entry) {
+            Pl_String raw("dedupe raw", nullptr, entry->data);
+            return !pipe_raw(entry->stream, &raw);
+        });
+    }
+
+    // Merging some streams can make the dictionaries of others equal, such as
+    // images with identical /SMask streams, so repeat until nothing changes
+    CanonicalMap canonical;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &[key, group] : candidates) {
+            std::map<std::string, StreamEntry *> first_with_dict;
+            for (auto *entry : group) {
+                auto og = entry->stream.getObjGen();
+                if (canonical.count(og))
+                    continue;
+                auto dict = normalized_dict(entry->stream, canonical);
+                auto [it, inserted] = first_with_dict.emplace(dict, entry);
+                if (inserted)
+                    continue;
+                // The digest is only a hint; the data must be identical
+                if (it->second->data != entry->data)
+                    continue;
+                auto target = it->second->stream.getObjGen();
+                // og may already be the target of earlier duplicates
+                for (auto &[from, to] : canonical)
+                    if (to == og)
+                        to = target;
+                canonical[og] = target;
+                ++result.duplicates;
+                result.bytes_saved += entry->size;
+                changed = true;
+            }
+        }
+    }
+    if (canonical.empty())
+        return result;
+
+    for (auto &oh : q.getAllObjects()) {
+        if (canonical.count(oh.getObjGen()))
+            continue;
+        if (oh.isStream())
+            rewrite_references(q, oh.getDict(), canonical);
+        else
+            rewrite_references(q, oh, canonical);
+    }
+    rewrite_references(q, q.getTrailer(), canonical);
+
+    for (auto const &item : canonical) {
+        q.replaceObject(item.first, QPDFObjectHandle::newNull());
+        forget_replaced_object(q, item.first);
+    }
+    return result;
+}
+
+} // namespace
+
+py::dict deduplicate_streams(QPDF &q)
+{
+    DedupeResult result;
+    {
+        py::gil_scoped_release release;
+        result = deduplicate(q);
+    }
+    py::dict stats;
+    stats["streams"] = result.streams;
+    stats["duplicates"] = result.duplicates;
+    stats["bytes_saved"] = result.bytes_saved;
+    return stats;
+}
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+// POSIX only; on Windows AccessMode.pread falls back to stream access.
+#if !defined(_WIN32)
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <qpdf/Constants.h>
+#include <qpdf/DLL.h>
+#include <qpdf/InputSource.hh>
+#include <qpdf/QIntC.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QUtil.hh>
+#include <qpdf/Types.h>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "inputsource_eol.h"
+#include "pikepdf.h"
+#include "utils.h"
+
+// An InputSource that reads from the operating system file descriptor behind a
+// Python file object, using pread(2). Unlike PythonStreamInputSource, reading,
+// seeking and telling never call back into Python, and unlike MmapInputSource,
+// page faults cannot raise SIGBUS if the file is truncated underneath us.
+//
+// We keep our own file position and never move the descriptor's position, so
+// the Python file object's idea of its position is not disturbed.
+//
+// GIL usage:
+// The GIL must be held while this class is constructed, by the constructor's caller,
+// since Python objects may be created/destroyed in the process of calling the
+// constructor. After construction, only the destructor needs the GIL (to release
+// and possibly close the Python stream). All other methods may be called with
+// the GIL released, and qpdf can parse the whole file without re-acquiring it.
+// The Python stream must remain open for as long as the Pdf is open, since we
+// borrow its file descriptor.
+class FileDescriptorInputSource : public InputSource {
+public:
+    FileDescriptorInputSource(
+        const py::object &stream, const std::string &description, bool close_stream)
+        : InputSource(), name(description), close_stream(close_stream)
+    {
+        py::gil_scoped_acquire acquire; // GIL must be held anyway, issue #295
+        this->stream = stream;
+
+        py::int_ fileno = this->stream.attr("fileno")();
+        this->fd = fileno;
+
+        struct stat st;
+        if (fstat(this->fd, &st) != 0) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, this->name.c_str());
+            throw py::error_already_set();
+        }
+        if (!S_ISREG(st.st_mode)) {
+            // Raise as a Python exception so open_pdf can fall back to stream access
+            PyErr_SetString(PyExc_ValueError, "pread access requires a regular file");
+            throw py::error_already_set();
+        }
+        this->size = st.st_size;
+    }
+    virtual ~FileDescriptorInputSource()
+    {
+        py::gil_scoped_acquire acquire;
+        try {
+            if (this->close_stream && py::hasattr(this->stream, "close")) {
+                this->stream.attr("close")();
+            }
+            // LCOV_EXCL_START
+        } catch (py::error_already_set &e) {
+            e.discard_as_unraisable(__func__);
+        } catch (const std::runtime_error &e) {
+            if (!str_startswith(e.what(), "StopIteration"))
+                std::cerr << "Exception in " << __func__ << ": " << e.what();
+        }
+        // LCOV_EXCL_STOP
+    }
+    // LCOV_EXCL_START
+    FileDescriptorInputSource(const FileDescriptorInputSource &) = delete;
+    FileDescriptorInputSource &operator=(const FileDescriptorInputSource &) = delete;
+    FileDescriptorInputSource(FileDescriptorInputSource &&) = delete;
+    FileDescriptorInputSource &operator=(FileDescriptorInputSource &&) = delete;
+    // LCOV_EXCL_STOP
+
+    std::string const &getName() const override { return this->name; }
+
+    qpdf_offset_t tell() override { return this->cur_offset; }
+
+    void seek(qpdf_offset_t offset, int whence) override
+    {
+        switch (whence) {
+        case SEEK_SET:
+            this->cur_offset = offset;
+            break;
+        case SEEK_END:
+            QIntC::range_check(this->size, offset);
+            this->cur_offset = this->size + offset;
+            break;
+        case SEEK_CUR:
+            QIntC::range_check(this->cur_offset, offset);
+            this->cur_offset += offset;
+            break;
+        default:
+            // LCOV_EXCL_START
+            throw std::logic_error(
+                "INTERNAL ERROR: invalid argument to FileDescriptorInputSource::seek");
+            // LCOV_EXCL_STOP
+        }
+        if (this->cur_offset < 0) {
+            throw std::runtime_error(this->name + ": seek before beginning of file");
+        }
+    }
+
+    // LCOV_EXCL_START
+    void rewind() override
+    {
+        // qpdf never seems to use this but still requires
+        this->cur_offset = 0;
+    }
+    // LCOV_EXCL_STOP
+
+    size_t read(char *buffer, size_t length) override
+    {
+        this->last_offset = this->cur_offset;
+        size_t bytes_read = this->pread_fully(buffer, length, this->cur_offset);
+        this->cur_offset += QIntC::to_offset(bytes_read);
+        return bytes_read;
+    }
+
+    void unreadCh(char ch) override
+    {
+        if (this->cur_offset > 0)
+            --this->cur_offset;
+    }
+
+    qpdf_offset_t findAndSkipNextEOL() override
+    {
+        return find_and_skip_next_eol<4096>(*this);
+    }
+
+private:
+    size_t pread_fully(char *buffer, size_t length, qpdf_offset_t offset)
+    {
+        size_t total = 0;
+        while (total < length) {
+            auto n = ::pread(this->fd,
+                buffer + total,
+                length - total,
+                static_cast<off_t>(offset + QIntC::to_offset(total)));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                QUtil::throw_system_error(this->name);
+            }
+            if (n == 0)
+                break; // EOF
+            total += static_cast<size_t>(n);
+        }
+        return total;
+    }
+
+    py::object stream;
+    std::string name;
+    bool close_stream;
+    int fd = -1;
+    qpdf_offset_t size = 0;
+    qpdf_offset_t cur_offset = 0;
+};
+
+#endif // !defined(_WIN32)
@@ -0,0 +1,382 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include <qpdf/Pipeline.hh>
+#include <qpdf/Pl_Flate.hh>
+#include <qpdf/Pl_PNGFilter.hh>
+#include <qpdf/Pl_TIFFPredictor.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/QPDFStreamFilter.hh>
+
+#ifdef PIKEPDF_WITH_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+#ifdef PIKEPDF_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "flate_backend.h"
+
+namespace {
+
+std::mutex registry_mutex;
+std::map<std::string, std::shared_ptr<FlateBackend>> registry;
+std::shared_ptr<FlateBackend> selected;
+bool filter_registered = false;
+
+// Decodes flate data with the selected backend, all at once when finished. If the
+// backend rejects the data, decodes it with qpdf's zlib pipeline instead.
+class Pl_BackendInflate : public Pipeline {
+public:
+    Pl_BackendInflate(
+        char const *identifier, Pipeline *next, std::shared_ptr<FlateBackend> backend)
+        : Pipeline(identifier, next), backend(std::move(backend))
+    {
+    }
+    virtual ~Pl_BackendInflate() = default;
+
+    void write(unsigned char const *data, size_t len) override
+    {
+        this->buffer.append(reinterpret_cast<char const *>(data), len);
+    }
+
+    void finish() override
+    {
+        std::string decoded;
+        bool decoded_ok = false;
+        try {
+            decoded = this->backend->decompress(this->buffer);
+            decoded_ok = true;
+        } catch (std::runtime_error &) {
+            // Fall through to qpdf's more forgiving decoder
+        }
+        if (decoded_ok) {
+            this->getNext()->writeString(decoded);
+            this->getNext()->finish();
+        } else {
+            Pl_Flate inflate("flate fallback", this->getNext(), Pl_Flate::a_inflate);
+            inflate.write(reinterpret_cast<unsigned char const *>(this->buffer.data()),
+                this->buffer.size());
+            inflate.finish();
+        }
+        this->buffer.clear();
+    }
+
+private:
+    std::shared_ptr<FlateBackend> backend;
+    std::string buffer;
+};
+
+// Replaces qpdf's /FlateDecode filter once a backend other than zlib has been
+// selected. Handles /DecodeParms the same way as qpdf's own filter.
+class FlateBackendStreamFilter : public QPDFStreamFilter {
+public:
+    bool setDecodeParms(QPDFObjectHandle decode_parms) override
+    {
+        // Like qpdf, treat anything other than a dictionary as empty
+        if (!decode_parms.isDictionary())
+            return true;
+
+        bool filterable = true;
+        for (auto const &key : decode_parms.getKeys()) {
+            auto value = decode_parms.getKey(key);
+            if (key == "/Predictor") {
+                if (value.isInteger()) {
+                    this->predictor = value.getIntValueAsInt();
+                    if (!(this->predictor == 1 || this->predictor == 2 ||
+                            (this->predictor >= 10 && this->predictor <= 15)))
+                        filterable = false;
+                } else {
+                    filterable = false;
+                }
+            } else if (key == "/Columns" || key == "/Colors" ||
+                       key == "/BitsPerComponent") {
+                if (value.isInteger() && value.getIntValue() > 0) {
+                    auto n = value.getUIntValueAsUInt();
+                    if (key == "/Columns")
+                        this->columns = n;
+                    else if (key == "/Colors")
+                        this->colors = n;
+                    else
+                        this->bits_per_component = n;
+                } else {
+                    filterable = false;
+                }
+            }
+        }
+        if (this->predictor > 1 && this->columns == 0)
+            filterable = false;
+        return filterable;
+    }
+
+    Pipeline *getDecodePipeline(Pipeline *next) override
+    {
+        if (this->predictor >= 10) {
+            this->pipelines.push_back(std::make_shared<Pl_PNGFilter>("png decode",
+                next,
+                Pl_PNGFilter::a_decode,
+                this->columns,
+                this->colors,
+                this->bits_per_component));
+            next = this->pipelines.back().get();
+        } else if (this->predictor == 2) {
+            this->pipelines.push_back(std::make_shared<Pl_TIFFPredictor>("tiff decode",
+                next,
+                Pl_TIFFPredictor::a_decode,
+                this->columns,
+                this->colors,
+                this->bits_per_component));
+            next = this->pipelines.back().get();
+        }
+
+        // If zlib was selected again after another backend, behave like qpdf
+        if (auto backend = get_flate_backend()) {
+            this->pipelines.push_back(
+                std::make_shared<Pl_BackendInflate>("flate decode", next, backend));
+        } else {
+            this->pipelines.push_back(
+                std::make_shared<Pl_Flate>("flate decode", next, Pl_Flate::a_inflate));
+        }
+        return this->pipelines.back().get();
+    }
+
+    static std::shared_ptr<QPDFStreamFilter> factory()
+    {
+        return std::make_shared<FlateBackendStreamFilter>();
+    }
+
+private:
+    int predictor = 1;
+    unsigned int columns = 0;
+    unsigned int colors = 1;
+    unsigned int bits_per_component = 8;
+    std::vector<std::shared_ptr<Pipeline>> pipelines;
+};
+
+#ifdef PIKEPDF_WITH_LIBDEFLATE
+// libdeflate is faster than zlib for both compression and decompression, but only
+// works on whole buffers, which is all we need. Its compressors and decompressors
+// are not thread-safe, so each thread keeps its own.
+class LibdeflateBackend : public FlateBackend {
+public:
+    std::string name() const override { return "libdeflate"; }
+
+    std::string compress(std::string_view data, int level) const override
+    {
+        if (level < 0)
+            level = 6; // zlib's default
+        thread_local Compressors compressors;
+        auto *compressor = compressors.get(level);
+        auto bound = libdeflate_zlib_compress_bound(compressor, data.size());
+        std::string out(bound, '\0');
+        auto n = libdeflate_zlib_compress(
+            compressor, data.data(), data.size(), out.data(), out.size());
+        if (n == 0)
+            throw std::runtime_error("libdeflate: compression failed");
+        out.resize(n);
+        return out;
+    }
+
+    std::string decompress(std::string_view data) const override
+    {
+        thread_local Decompressor decompressor;
+        size_t capacity = std::max<size_t>(data.size() * 4, 4096);
+        std::string out;
+        while (true) {
+            out.resize(capacity);
+            size_t actual_in = 0, actual_out = 0;
+            // Use the _ex variant so that bytes after the end of the zlib stream,
+            // which are common in PDFs, are not an error
+            auto result = libdeflate_zlib_decompress_ex(decompressor.d,
+                data.data(),
+                data.size(),
+                out.data(),
+                out.size(),
+                &actual_in,
+                &actual_out);
+            if (result == LIBDEFLATE_SUCCESS) {
+                out.resize(actual_out);
+                return out;
+            }
+            if (result != LIBDEFLATE_INSUFFICIENT_SPACE || capacity > out.max_size() / 2)
+                throw std::runtime_error("libdeflate: invalid flate data");
+            capacity *= 2;
+        }
+    }
+
+private:
+    struct Compressors {
+        libdeflate_compressor *c[10] = {};
+        ~Compressors()
+        {
+            for (auto *compressor : c)
+                if (compressor)
+                    libdeflate_free_compressor(compressor);
+        }
+        libdeflate_compressor *get(int level)
+        {
+            if (!c[level]) {
+                c[level] = libdeflate_alloc_compressor(level);
+                if (!c[level])
+                    throw std::bad_alloc();
+            }
+            return c[level];
+        }
+    };
+    struct Decompressor {
+        libdeflate_decompressor *d = libdeflate_alloc_decompressor();
+        ~Decompressor()
+        {
+            if (d)
+                libdeflate_free_decompressor(d);
+        }
+    };
+};
+#endif
+
+#ifdef PIKEPDF_WITH_ZLIB
+// zlib with the same settings as qpdf's Pl_Flate, but with the level given per call.
+// zlib counts input in uInt, so data is fed to it in pieces.
+class ZlibBackend : public FlateBackend {
+public:
+    std::string name() const override { return "zlib"; }
+
+    std::string compress(std::string_view data, int level) const override
+    {
+        z_stream zs{};
+        if (deflateInit(&zs, level) != Z_OK)
+            throw std::runtime_error("zlib: could not initialize compression");
+        std::string out;
+        int result;
+        do {
+            feed(zs, data);
+            bool last = data.empty() && zs.avail_in == 0;
+            result = deflate_chunk(zs, out, last ? Z_FINISH : Z_NO_FLUSH);
+        } while (result == Z_OK);
+        deflateEnd(&zs);
+        if (result != Z_STREAM_END)
+            throw std::runtime_error("zlib: compression failed");
+        return out;
+    }
+
+    std::string decompress(std::string_view data) const override
+    {
+        z_stream zs{};
+        if (inflateInit(&zs) != Z_OK)
+            throw std::runtime_error("zlib: could not initialize decompression");
+        std::string out;
+        int result;
+        do {
+            feed(zs, data);
+            unsigned char chunk[65536];
+            zs.next_out = chunk;
+            zs.avail_out = sizeof(chunk);
+            result = inflate(&zs, Z_NO_FLUSH);
+            out.append(reinterpret_cast<char *>(chunk), sizeof(chunk) - zs.avail_out);
+        } while (result == Z_OK);
+        inflateEnd(&zs);
+        if (result != Z_STREAM_END)
+            throw std::runtime_error("zlib: invalid flate data");
+        return out;
+    }
+
+private:
+    // Give zlib the next piece of data once it has used the last one
+    static void feed(z_stream &zs, std::string_view &data)
+    {
+        if (zs.avail_in != 0 || data.empty())
+            return;
+        auto n = std::min<size_t>(data.size(), 1u << 30);
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+        zs.avail_in = static_cast<uInt>(n);
+        data.remove_prefix(n);
+    }
+
+    static int deflate_chunk(z_stream &zs, std::string &out, int flush)
+    {
+        unsigned char chunk[65536];
+        zs.next_out = chunk;
+        zs.avail_out = sizeof(chunk);
+        int result = deflate(&zs, flush);
+        out.append(reinterpret_cast<char *>(chunk), sizeof(chunk) - zs.avail_out);
+        return result;
+    }
+};
+#endif
+
+} // namespace
+
+void register_flate_backend(std::shared_ptr<FlateBackend> backend)
+{
+    if (!backend || backend->name() == "zlib")
+        throw std::invalid_argument("cannot replace the zlib flate backend");
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry[backend->name()] = backend;
+}
+
+std::vector<std::string> flate_backend_names()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::vector<std::string> names{"zlib"};
+    for (auto const &[name, backend] : registry)
+        names.push_back(name);
+    return names;
+}
+
+std::string set_flate_backend(std::string const &name)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto previous = selected ? selected->name() : std::string("zlib");
+    if (name == "zlib") {
+        selected.reset();
+        return previous;
+    }
+    auto it = registry.find(name);
+    if (it == registry.end())
+        throw std::invalid_argument("no flate backend named " + name);
+    selected = it->second;
+    if (!filter_registered) {
+        // qpdf does not let us remove a filter once registered, so from now on
+        // our filter decodes flate data. With zlib selected again it builds the
+        // same pipeline as qpdf's own filter.
+        QPDF::registerStreamFilter("/FlateDecode", &FlateBackendStreamFilter::factory);
+        QPDF::registerStreamFilter("/Fl", &FlateBackendStreamFilter::factory);
+        filter_registered = true;
+    }
+    return previous;
+}
+
+std::string get_flate_backend_name()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return selected ? selected->name() : std::string("zlib");
+}
+
+std::shared_ptr<FlateBackend> get_flate_backend()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return selected;
+}
+
+std::shared_ptr<FlateBackend> get_zlib_level_backend()
+{
+#ifdef PIKEPDF_WITH_ZLIB
+    static auto const backend = std::make_shared<ZlibBackend>();
+    return backend;
+#else
+    return nullptr;
+#endif
+}
+
+void init_flate_backends()
+{
+#ifdef PIKEPDF_WITH_LIBDEFLATE
+    register_flate_backend(std::make_shared<LibdeflateBackend>());
+#endif
+}
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A whole-buffer implementation of flate (zlib format, RFC 1950), used for
+// /FlateDecode stream data in place of qpdf's streaming zlib pipeline.
+//
+// Backends must be thread-safe, since they are called from worker threads while
+// saving, and must not call into Python.
+class FlateBackend {
+public:
+    virtual ~FlateBackend() = default;
+
+    virtual std::string name() const = 0;
+
+    // Compress data at a zlib level from 0 to 9.
+    virtual std::string compress(std::string_view data, int level) const = 0;
+
+    // Decompress a complete zlib stream. Throws std::runtime_error if the data is
+    // not valid, in which case the caller falls back to qpdf's own decoder, which is
+    // more forgiving of the damaged streams found in real PDFs.
+    virtual std::string decompress(std::string_view data) const = 0;
+};
+
+// Make a backend available for selection by name. Replaces any backend with the
+// same name.
+void register_flate_backend(std::shared_ptr<FlateBackend> backend);
+
+// Names of the available backends, always including "zlib", which is qpdf's own.
+std::vector<std::string> flate_backend_names();
+
+// Select the backend to use for all flate encoding and decoding. Throws
+// std::invalid_argument if there is no backend of that name. Returns the name of
+// the previously selected backend.
+std::string set_flate_backend(std::string const &name);
+
+std::string get_flate_backend_name();
+
+// Register the backends that pikepdf was built with
+void init_flate_backends();
+
+// The selected backend, or nullptr if qpdf's own zlib is selected, in which case
+// flate data should be handled by qpdf as usual.
+std::shared_ptr<FlateBackend> get_flate_backend();
+
+// A backend that calls zlib directly, for compressing at a level of our choosing
+// when "zlib" is selected, since qpdf only has a process-wide level. nullptr if
+// pikepdf was built without zlib.
+std::shared_ptr<FlateBackend> get_zlib_level_backend();
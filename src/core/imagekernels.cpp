@@ -0,0 +1,393 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+// Unpacking of sub-byte image samples.
+//
+// Every call builds a table of the output bytes for each possible input byte,
+// which handles any scale, and is used for 1-bit samples and the ends of buffers.
+// When each output is the sample times a small integer, as for grayscale levels
+// and palette indexes, 2 and 4-bit samples are unpacked with SIMD instead: SSE2 on
+// x86-64, or AVX2 if the processor has it, and NEON on ARM64.
+//
+// Palette expansion unpacks each row of indexes that way, then copies the color of
+// each index from a table of all 256 possible indexes.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIKEPDF_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is chosen at runtime, so only where the compiler can target it per function
+#if (defined(__x86_64__) || defined(__i386__)) &&                                      \
+    (defined(__GNUC__) || defined(__clang__))
+#define PIKEPDF_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define PIKEPDF_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "imagekernels.h"
+
+namespace {
+
+struct UnpackPlan {
+    int bits = 0;
+    // XORed with each sample, to invert it
+    uint8_t flip = 0;
+    // If linear, each output byte is the (flipped) sample times factor
+    bool linear = false;
+    uint8_t factor = 0;
+    // The output bytes for each input byte, 8 / bits of them
+    uint8_t table[256][8] = {};
+};
+
+void make_plan(UnpackPlan &plan, int bits, double scale, bool invert)
+{
+    if (bits != 1 && bits != 2 && bits != 4)
+        throw std::invalid_argument("bits per sample must be 1, 2 or 4");
+    int const max_sample = (1 << bits) - 1;
+    int const per_byte = 8 / bits;
+
+    uint8_t levels[16];
+    for (int s = 0; s <= max_sample; ++s) {
+        double value = s * scale;
+        if (!(value >= 0.0 && value < 256.0))
+            throw std::invalid_argument("scaled sample does not fit in a byte");
+        levels[s] = static_cast<uint8_t>(value);
+    }
+
+    plan.bits = bits;
+    plan.flip = static_cast<uint8_t>(invert ? max_sample : 0);
+    plan.factor = levels[1];
+    plan.linear = true;
+    for (int s = 0; s <= max_sample; ++s)
+        if (levels[s] != s * plan.factor)
+            plan.linear = false;
+
+    for (int b = 0; b < 256; ++b)
+        for (int k = 0; k < per_byte; ++k) {
+            int sample = (b >> (8 - bits * (k + 1))) & max_sample;
+            plan.table[b][k] = levels[sample ^ plan.flip];
+        }
+}
+
+template <int Bits>
+void unpack_scalar(uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    constexpr size_t per_byte = 8 / Bits;
+    for (size_t i = 0; i < n; ++i)
+        std::memcpy(out + i * per_byte, plan.table[in[i]], per_byte);
+}
+
+// The SIMD kernels unpack whole blocks of input and return how many bytes they
+// consumed; the rest is left for unpack_scalar. Multiplying 16-bit lanes scales
+// both of their bytes at once, since no product exceeds a byte.
+
+#ifdef PIKEPDF_KERNELS_SSE2
+inline __m128i sse2_finish(__m128i v, __m128i flip, __m128i factor)
+{
+    return _mm_mullo_epi16(_mm_xor_si128(v, flip), factor);
+}
+
+size_t unpack_sse2(uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    auto flip = _mm_set1_epi8(static_cast<char>(plan.flip));
+    auto factor = _mm_set1_epi16(plan.factor);
+    size_t i = 0;
+    if (plan.bits == 4) {
+        auto mask = _mm_set1_epi8(0x0f);
+        for (; i + 16 <= n; i += 16) {
+            auto x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+            auto hi = sse2_finish(
+                _mm_and_si128(_mm_srli_epi16(x, 4), mask), flip, factor);
+            auto lo = sse2_finish(_mm_and_si128(x, mask), flip, factor);
+            auto *o = reinterpret_cast<__m128i *>(out + 2 * i);
+            _mm_storeu_si128(o, _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(o + 1, _mm_unpackhi_epi8(hi, lo));
+        }
+    } else if (plan.bits == 2) {
+        auto mask = _mm_set1_epi8(0x03);
+        for (; i + 16 <= n; i += 16) {
+            auto x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+            auto s0 = sse2_finish(
+                _mm_and_si128(_mm_srli_epi16(x, 6), mask), flip, factor);
+            auto s1 = sse2_finish(
+                _mm_and_si128(_mm_srli_epi16(x, 4), mask), flip, factor);
+            auto s2 = sse2_finish(
+                _mm_and_si128(_mm_srli_epi16(x, 2), mask), flip, factor);
+            auto s3 = sse2_finish(_mm_and_si128(x, mask), flip, factor);
+            auto a_lo = _mm_unpacklo_epi8(s0, s1);
+            auto a_hi = _mm_unpackhi_epi8(s0, s1);
+            auto b_lo = _mm_unpacklo_epi8(s2, s3);
+            auto b_hi = _mm_unpackhi_epi8(s2, s3);
+            auto *o = reinterpret_cast<__m128i *>(out + 4 * i);
+            _mm_storeu_si128(o, _mm_unpacklo_epi16(a_lo, b_lo));
+            _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(a_lo, b_lo));
+            _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(a_hi, b_hi));
+            _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(a_hi, b_hi));
+        }
+    }
+    return i;
+}
+#endif
+
+#ifdef PIKEPDF_KERNELS_AVX2
+__attribute__((target("avx2"))) inline __m256i avx2_finish(
+    __m256i v, __m256i flip, __m256i factor)
+{
+    return _mm256_mullo_epi16(_mm256_xor_si256(v, flip), factor);
+}
+
+// Unpacking works within each 128-bit lane, so the halves of the results are
+// put back in order as they are stored.
+__attribute__((target("avx2"))) size_t unpack_avx2(
+    uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    auto flip = _mm256_set1_epi8(static_cast<char>(plan.flip));
+    auto factor = _mm256_set1_epi16(plan.factor);
+    size_t i = 0;
+    if (plan.bits == 4) {
+        auto mask = _mm256_set1_epi8(0x0f);
+        for (; i + 32 <= n; i += 32) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+            auto hi = avx2_finish(
+                _mm256_and_si256(_mm256_srli_epi16(x, 4), mask), flip, factor);
+            auto lo = avx2_finish(_mm256_and_si256(x, mask), flip, factor);
+            auto a = _mm256_unpacklo_epi8(hi, lo);
+            auto b = _mm256_unpackhi_epi8(hi, lo);
+            auto *o = reinterpret_cast<__m256i *>(out + 2 * i);
+            _mm256_storeu_si256(o, _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256(o + 1, _mm256_permute2x128_si256(a, b, 0x31));
+        }
+    } else if (plan.bits == 2) {
+        auto mask = _mm256_set1_epi8(0x03);
+        for (; i + 32 <= n; i += 32) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+            auto s0 = avx2_finish(
+                _mm256_and_si256(_mm256_srli_epi16(x, 6), mask), flip, factor);
+            auto s1 = avx2_finish(
+                _mm256_and_si256(_mm256_srli_epi16(x, 4), mask), flip, factor);
+            auto s2 = avx2_finish(
+                _mm256_and_si256(_mm256_srli_epi16(x, 2), mask), flip, factor);
+            auto s3 = avx2_finish(_mm256_and_si256(x, mask), flip, factor);
+            auto a_lo = _mm256_unpacklo_epi8(s0, s1);
+            auto a_hi = _mm256_unpackhi_epi8(s0, s1);
+            auto b_lo = _mm256_unpacklo_epi8(s2, s3);
+            auto b_hi = _mm256_unpackhi_epi8(s2, s3);
+            // Each holds the samples of 4 input bytes from each half of the block
+            auto r0 = _mm256_unpacklo_epi16(a_lo, b_lo);
+            auto r1 = _mm256_unpackhi_epi16(a_lo, b_lo);
+            auto r2 = _mm256_unpacklo_epi16(a_hi, b_hi);
+            auto r3 = _mm256_unpackhi_epi16(a_hi, b_hi);
+            auto *o = reinterpret_cast<__m256i *>(out + 4 * i);
+            _mm256_storeu_si256(o, _mm256_permute2x128_si256(r0, r1, 0x20));
+            _mm256_storeu_si256(o + 1, _mm256_permute2x128_si256(r2, r3, 0x20));
+            _mm256_storeu_si256(o + 2, _mm256_permute2x128_si256(r0, r1, 0x31));
+            _mm256_storeu_si256(o + 3, _mm256_permute2x128_si256(r2, r3, 0x31));
+        }
+    }
+    return i;
+}
+
+bool cpu_has_avx2()
+{
+    static bool const has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+#ifdef PIKEPDF_KERNELS_NEON
+size_t unpack_neon(uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    auto flip = vdupq_n_u8(plan.flip);
+    auto factor = vdupq_n_u8(plan.factor);
+    auto finish = [&](uint8x16_t v) { return vmulq_u8(veorq_u8(v, flip), factor); };
+    size_t i = 0;
+    if (plan.bits == 4) {
+        auto mask = vdupq_n_u8(0x0f);
+        for (; i + 16 <= n; i += 16) {
+            auto x = vld1q_u8(in + i);
+            uint8x16x2_t s;
+            s.val[0] = finish(vshrq_n_u8(x, 4));
+            s.val[1] = finish(vandq_u8(x, mask));
+            vst2q_u8(out + 2 * i, s);
+        }
+    } else if (plan.bits == 2) {
+        auto mask = vdupq_n_u8(0x03);
+        for (; i + 16 <= n; i += 16) {
+            auto x = vld1q_u8(in + i);
+            uint8x16x4_t s;
+            s.val[0] = finish(vshrq_n_u8(x, 6));
+            s.val[1] = finish(vandq_u8(vshrq_n_u8(x, 4), mask));
+            s.val[2] = finish(vandq_u8(vshrq_n_u8(x, 2), mask));
+            s.val[3] = finish(vandq_u8(x, mask));
+            vst4q_u8(out + 4 * i, s);
+        }
+    }
+    return i;
+}
+#endif
+
+size_t unpack_simd(uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    if (!plan.linear)
+        return 0;
+#ifdef PIKEPDF_KERNELS_AVX2
+    if (cpu_has_avx2())
+        return unpack_avx2(in, n, out, plan);
+#endif
+#if defined(PIKEPDF_KERNELS_SSE2)
+    return unpack_sse2(in, n, out, plan);
+#elif defined(PIKEPDF_KERNELS_NEON)
+    return unpack_neon(in, n, out, plan);
+#else
+    (void)in;
+    (void)n;
+    (void)out;
+    return 0;
+#endif
+}
+
+// Unpack n bytes of input, 8 / plan.bits output bytes for each
+void unpack_planned(uint8_t const *in, size_t n, uint8_t *out, UnpackPlan const &plan)
+{
+    size_t done = unpack_simd(in, n, out, plan);
+    in += done;
+    out += done * (8 / plan.bits);
+    n -= done;
+    switch (plan.bits) {
+    case 1:
+        unpack_scalar<1>(in, n, out, plan);
+        break;
+    case 2:
+        unpack_scalar<2>(in, n, out, plan);
+        break;
+    case 4:
+        unpack_scalar<4>(in, n, out, plan);
+        break;
+    }
+}
+
+template <int Components>
+void lookup_row(
+    uint8_t const *indexes, size_t width, uint8_t const (*entries)[4], uint8_t *out)
+{
+    for (size_t x = 0; x < width; ++x)
+        std::memcpy(out + x * Components, entries[indexes[x]], Components);
+}
+
+} // namespace
+
+void unpack_subbyte_pixels(unsigned char const *in,
+    size_t in_size,
+    unsigned char *out,
+    size_t out_size,
+    int bits,
+    double scale,
+    bool invert)
+{
+    UnpackPlan plan;
+    make_plan(plan, bits, scale, invert);
+    unpack_planned(in, std::min(in_size, out_size / (8 / bits)), out, plan);
+}
+
+size_t expanded_palette_size(size_t width, size_t height, int components)
+{
+    if (components < 1 || components > 4)
+        throw std::invalid_argument("palette entries must have 1 to 4 components");
+    size_t pixels = width * height;
+    if (height != 0 && pixels / height != width)
+        throw std::length_error("image is too large");
+    if (pixels > SIZE_MAX / components)
+        throw std::length_error("image is too large");
+    return pixels * components;
+}
+
+void expand_palette(unsigned char const *in,
+    size_t in_size,
+    size_t width,
+    size_t height,
+    int bits,
+    unsigned char const *palette,
+    size_t palette_size,
+    int components,
+    unsigned char *out)
+{
+    if (bits != 1 && bits != 2 && bits != 4 && bits != 8)
+        throw std::invalid_argument("bits per index must be 1, 2, 4 or 8");
+    size_t const row_out = expanded_palette_size(width, 1, components);
+    size_t const n_entries = palette_size / components;
+    if (n_entries == 0)
+        throw std::invalid_argument("palette is empty");
+
+    // Out of range indexes are clipped to the last entry
+    uint8_t entries[256][4] = {};
+    for (size_t i = 0; i < 256; ++i)
+        std::memcpy(entries[i],
+            palette + std::min(i, n_entries - 1) * components,
+            components);
+
+    UnpackPlan plan;
+    if (bits < 8)
+        make_plan(plan, bits, 1.0, false);
+    size_t const row_bytes = (width * bits + 7) / 8;
+    std::vector<uint8_t> row_in(row_bytes);
+    std::vector<uint8_t> indexes(bits < 8 ? row_bytes * (8 / bits) : 0);
+
+    for (size_t y = 0; y < height; ++y) {
+        // Samples missing from the end of the data are taken to be index 0
+        size_t offset = y * row_bytes;
+        size_t available = offset < in_size ? std::min(row_bytes, in_size - offset) : 0;
+        uint8_t const *row = row_in.data();
+        if (available == row_bytes) {
+            row = in + offset;
+        } else {
+            std::fill(row_in.begin(), row_in.end(), 0);
+            if (available)
+                std::memcpy(row_in.data(), in + offset, available);
+        }
+        if (bits < 8) {
+            unpack_planned(row, row_bytes, indexes.data(), plan);
+            row = indexes.data();
+        }
+        auto *row_dest = out + y * row_out;
+        switch (components) {
+        case 1:
+            lookup_row<1>(row, width, entries, row_dest);
+            break;
+        case 2:
+            lookup_row<2>(row, width, entries, row_dest);
+            break;
+        case 3:
+            lookup_row<3>(row, width, entries, row_dest);
+            break;
+        case 4:
+            lookup_row<4>(row, width, entries, row_dest);
+            break;
+        }
+    }
+}
+
+char const *image_kernel_isa()
+{
+#ifdef PIKEPDF_KERNELS_AVX2
+    if (cpu_has_avx2())
+        return "avx2";
+#endif
+#if defined(PIKEPDF_KERNELS_SSE2)
+    return "sse2";
+#elif defined(PIKEPDF_KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
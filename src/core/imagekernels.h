@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstddef>
+
+// Unpack 1, 2 or 4 bit samples, most significant bits first, to one byte each, as
+// image extraction does for images with fewer than 8 bits per component. The input
+// is read as one run of bytes, so each row's padding bits become padding samples.
+//
+// Each sample s becomes int(s * scale), or int((2**bits - 1 - s) * scale) if
+// invert is set, as for a /Decode array of [1 0]. Reads at most out_size / (8 /
+// bits) bytes of input, and leaves the rest of out unchanged if the input is
+// shorter. Thread-safe and does not call into Python. Throws
+// std::invalid_argument if bits is not 1, 2 or 4, or a sample would not fit in a
+// byte.
+void unpack_subbyte_pixels(unsigned char const *in,
+    size_t in_size,
+    unsigned char *out,
+    size_t out_size,
+    int bits,
+    double scale,
+    bool invert);
+
+// The instruction set unpack_subbyte_pixels() uses on this machine: "avx2",
+// "sse2", "neon" or "scalar".
+char const *image_kernel_isa();
+
+// The number of bytes expand_palette() writes. Throws std::invalid_argument if
+// components is not 1 to 4, or std::length_error if the size would overflow.
+size_t expanded_palette_size(size_t width, size_t height, int components);
+
+// Expand an Indexed image of 1, 2, 4 or 8 bits per index, with each row starting
+// on a byte boundary, by looking up each index in palette, whose entries are
+// components bytes each. Writes expanded_palette_size() bytes to out, in rows of
+// width * components bytes. Indexes past the end of the palette use its last
+// entry, and samples missing from the end of the input are taken to be index 0.
+// Thread-safe and does not call into Python.
+void expand_palette(unsigned char const *in,
+    size_t in_size,
+    size_t width,
+    size_t height,
+    int bits,
+    unsigned char const *palette,
+    size_t palette_size,
+    int components,
+    unsigned char *out);
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/QPDFPageDocumentHelper.hh>
+#include <qpdf/QPDFPageObjectHelper.hh>
+
+#include "pikepdf.h"
+
+namespace {
+
+struct FoundImage {
+    QPDFObjectHandle image;
+    std::string name;
+    std::vector<size_t> pages;
+};
+
+} // namespace
+
+py::list collect_images(QPDF &q)
+{
+    std::vector<FoundImage> found;
+    std::map<QPDFObjGen, size_t> index;
+    {
+        py::gil_scoped_release release;
+        auto pages = QPDFPageDocumentHelper(q).getAllPages();
+        for (size_t n = 0; n < pages.size(); ++n) {
+            pages[n].forEachImage(true,
+                [&](QPDFObjectHandle &image,
+                    QPDFObjectHandle & /*xobjects*/,
+                    std::string const &key) {
+                    size_t i = found.size();
+                    if (image.isIndirect())
+                        i = index.try_emplace(image.getObjGen(), i).first->second;
+                    if (i == found.size())
+                        found.push_back({image, key, {}});
+                    // An image may be drawn more than once on a page
+                    auto &pages_used = found[i].pages;
+                    if (pages_used.empty() || pages_used.back() != n)
+                        pages_used.push_back(n);
+                });
+        }
+    }
+
+    py::list result;
+    for (auto &item : found)
+        result.append(py::make_tuple(item.image, item.name, py::cast(item.pages)));
+    return result;
+}
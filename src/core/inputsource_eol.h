@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdio>
+#include <string_view>
+
+#include <qpdf/InputSource.hh>
+#include <qpdf/QIntC.hh>
+#include <qpdf/Types.h>
+
+// findAndSkipNextEOL() for our InputSources, which implement it in terms of their
+// own read(). Same semantics as qpdf's FileInputSource: return the offset of the
+// first EOL character at or after the current position, and leave the current
+// position after the EOL sequence.
+//
+// BufferSize is how much is read at a time; sources with a block cache should keep
+// it small enough for reads to be served from the cache.
+template <size_t BufferSize = 1024>
+qpdf_offset_t find_and_skip_next_eol(InputSource &source)
+{
+    char buf[BufferSize];
+    while (true) {
+        qpdf_offset_t buf_offset = source.tell();
+        size_t len = source.read(buf, sizeof(buf));
+        if (len == 0)
+            return source.tell();
+        std::string_view view(buf, len);
+        size_t found = view.find_first_of("\r\n");
+        if (found == std::string_view::npos)
+            continue;
+
+        qpdf_offset_t result = buf_offset + QIntC::to_offset(found);
+        source.seek(result + 1, SEEK_SET);
+        char ch;
+        while (source.read(&ch, 1) == 1) {
+            if (ch != '\r' && ch != '\n') {
+                source.unreadCh(ch);
+                break;
+            }
+        }
+        return result;
+    }
+}
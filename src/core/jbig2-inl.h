@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MPL-2.0
 
 #include "pikepdf.h"
+#include "jbig2dec.h"
 
 #include <cstdio>
 #include <cstring>
@@ -23,9 +24,14 @@ py::object get_decoder(py::gil_scoped_acquire &gil)
 
 class Pl_JBIG2 : public Pipeline {
 public:
-    Pl_JBIG2(
-        const char *identifier, Pipeline *next, const std::string &jbig2globals = "")
-        : Pipeline(identifier, next), jbig2globals(jbig2globals)
+    Pl_JBIG2(const char *identifier,
+        Pipeline *next,
+        std::shared_ptr<const std::string> jbig2globals = nullptr,
+        bool native = false)
+        : Pipeline(identifier, next),
+          jbig2globals(
+              jbig2globals ? jbig2globals : std::make_shared<const std::string>()),
+          native(native)
     {
     }
     virtual ~Pl_JBIG2() = default;
@@ -45,7 +51,7 @@ public:
 
         py::bytes extracted;
         try {
-            extracted = extract_jbig2(pydata, py::bytes(this->jbig2globals));
+            extracted = extract_jbig2(pydata, py::bytes(*this->jbig2globals));
         } catch (py::error_already_set &e) {
             // In qpdf over here...
             // https://github.com/qpdf/qpdf/blob/dd3b2cedd3164692925df1ef7414eb452343372f/libqpdf/QPDF.cc#L2955-2984
@@ -69,7 +75,9 @@ public:
             return;
         }
 
-        auto extracted = this->decode_jbig2(data);
+        // The native decoder needs neither the GIL nor a subprocess
+        auto extracted = this->native ? jbig2dec_decode(data, *this->jbig2globals)
+                                      : this->decode_jbig2(data);
 
         this->getNext()->write(extracted.data(), extracted.length());
 
@@ -81,7 +89,8 @@ public:
 
 private:
     // Do not hold any Python objects in this class to avoid GIL issues.
-    std::string jbig2globals;
+    std::shared_ptr<const std::string> jbig2globals;
+    bool native;
     std::stringstream ss;
 };
 
@@ -96,9 +105,8 @@ public:
         if (jbig2globals_obj.isNull())
             return true;
 
-        auto buf = jbig2globals_obj.getStreamData();
-        this->jbig2globals =
-            std::string(reinterpret_cast<char *>(buf->getBuffer()), buf->getSize());
+        // Usually shared by many images, so cached
+        this->jbig2globals = jbig2_globals_data(jbig2globals_obj);
         return true;
     }
 
@@ -111,9 +119,11 @@ public:
 
     virtual Pipeline *getDecodePipeline(Pipeline *next) override
     {
-        this->assertDecoderAvailable();
-        this->pipeline =
-            std::make_shared<Pl_JBIG2>("JBIG2 decode", next, this->jbig2globals);
+        bool native = jbig2_native_decoding();
+        if (!native)
+            this->assertDecoderAvailable();
+        this->pipeline = std::make_shared<Pl_JBIG2>(
+            "JBIG2 decode", next, this->jbig2globals, native);
         return this->pipeline.get();
     }
 
@@ -127,6 +137,6 @@ public:
 
 private:
     // Do not hold any Python objects in this class to avoid GIL issues.
-    std::string jbig2globals;
+    std::shared_ptr<const std::string> jbig2globals;
     std::shared_ptr<Pipeline> pipeline;
 };
\ No newline at end of file
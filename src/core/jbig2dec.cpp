@@ -0,0 +1,284 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <qpdf/Buffer.hh>
+#include <qpdf/QPDF.hh>
+
+#ifdef PIKEPDF_WITH_JBIG2DEC
+#include <jbig2.h>
+#endif
+
+#include "jbig2dec.h"
+
+namespace {
+
+std::atomic<bool> native_decoding{false};
+
+// A map that keeps only its most recently used entries
+template <typename Key, typename Value>
+class LruMap {
+public:
+    explicit LruMap(size_t capacity) : capacity(capacity) {}
+
+    Value *find(Key const &key)
+    {
+        auto it = this->index.find(key);
+        if (it == this->index.end())
+            return nullptr;
+        this->entries.splice(this->entries.begin(), this->entries, it->second);
+        return &it->second->second;
+    }
+
+    Value &insert(Key key, Value value)
+    {
+        this->erase(key);
+        this->entries.emplace_front(std::move(key), std::move(value));
+        this->index[this->entries.front().first] = this->entries.begin();
+        while (this->entries.size() > this->capacity) {
+            this->index.erase(this->entries.back().first);
+            this->entries.pop_back();
+        }
+        return this->entries.front().second;
+    }
+
+    void erase(Key const &key)
+    {
+        auto it = this->index.find(key);
+        if (it == this->index.end())
+            return;
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+
+    void clear()
+    {
+        this->index.clear();
+        this->entries.clear();
+    }
+
+private:
+    using Entries = std::list<std::pair<Key, Value>>;
+    size_t capacity;
+    Entries entries;
+    std::map<Key, typename Entries::iterator> index;
+};
+
+// Globals are usually small, and a document rarely has more than a few
+constexpr size_t globals_data_capacity = 32;
+constexpr size_t globals_parsed_capacity = 4;
+
+using GlobalsKey = std::pair<unsigned long long, QPDFObjGen>;
+std::mutex globals_data_mutex;
+LruMap<GlobalsKey, std::shared_ptr<const std::string>> globals_data_cache(
+    globals_data_capacity);
+
+std::atomic<size_t> data_hits{0};
+std::atomic<size_t> data_misses{0};
+std::atomic<size_t> parse_hits{0};
+std::atomic<size_t> parse_misses{0};
+
+std::optional<GlobalsKey> globals_key(QPDFObjectHandle &stream)
+{
+    auto *owner = stream.getOwningQPDF();
+    if (!owner || !stream.isIndirect())
+        return std::nullopt;
+    return GlobalsKey(owner->getUniqueId(), stream.getObjGen());
+}
+
+#ifdef PIKEPDF_WITH_JBIG2DEC
+// Keeps the first fatal error, to report once jbig2dec gives up
+struct ErrorState {
+    std::string message;
+};
+
+void on_jbig2_error(
+    void *data, const char *msg, Jbig2Severity severity, uint32_t /*seg_idx*/)
+{
+    auto *state = static_cast<ErrorState *>(data);
+    if (severity == JBIG2_SEVERITY_FATAL && state->message.empty())
+        state->message = msg ? msg : "unknown error";
+}
+
+struct CtxDeleter {
+    void operator()(Jbig2Ctx *ctx) const { jbig2_ctx_free(ctx); }
+};
+using CtxPtr = std::unique_ptr<Jbig2Ctx, CtxDeleter>;
+
+struct GlobalCtxDeleter {
+    void operator()(Jbig2GlobalCtx *ctx) const { jbig2_global_ctx_free(ctx); }
+};
+using GlobalCtxPtr = std::unique_ptr<Jbig2GlobalCtx, GlobalCtxDeleter>;
+
+[[noreturn]] void fail(ErrorState const &state, const char *what)
+{
+    std::string msg = std::string("jbig2dec: ") + what;
+    if (!state.message.empty())
+        msg += ": " + state.message;
+    throw std::runtime_error(msg);
+}
+
+CtxPtr new_context(Jbig2GlobalCtx *global_ctx, ErrorState &state)
+{
+    CtxPtr ctx(jbig2_ctx_new(
+        nullptr, JBIG2_OPTIONS_EMBEDDED, global_ctx, on_jbig2_error, &state));
+    if (!ctx)
+        fail(state, "could not create decoder");
+    return ctx;
+}
+
+// A parsed global context is only used by one page decoder at a time, so each
+// thread keeps its own
+thread_local LruMap<std::string, GlobalCtxPtr> parsed_globals(globals_parsed_capacity);
+
+Jbig2GlobalCtx *get_parsed_globals(std::string const &globals, ErrorState &state)
+{
+    if (auto *found = parsed_globals.find(globals)) {
+        parse_hits++;
+        return found->get();
+    }
+    parse_misses++;
+    auto ctx = new_context(nullptr, state);
+    if (jbig2_data_in(ctx.get(),
+            reinterpret_cast<const unsigned char *>(globals.data()),
+            globals.size()) < 0)
+        fail(state, "invalid JBIG2Globals");
+    // Takes ownership of the context
+    GlobalCtxPtr global_ctx(jbig2_make_global_ctx(ctx.release()));
+    return parsed_globals.insert(globals, std::move(global_ctx)).get();
+}
+#endif
+
+} // namespace
+
+bool jbig2dec_native_available()
+{
+#ifdef PIKEPDF_WITH_JBIG2DEC
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef PIKEPDF_WITH_JBIG2DEC
+std::string jbig2dec_decode(std::string const &data, std::string const &globals)
+{
+    ErrorState state;
+
+    Jbig2GlobalCtx *global_ctx = nullptr;
+    if (!globals.empty())
+        global_ctx = get_parsed_globals(globals, state);
+
+    auto ctx = new_context(global_ctx, state);
+    if (jbig2_data_in(ctx.get(),
+            reinterpret_cast<const unsigned char *>(data.data()),
+            data.size()) < 0)
+        fail(state, "invalid JBIG2 data");
+    if (jbig2_complete_page(ctx.get()) < 0)
+        fail(state, "could not complete page");
+    Jbig2Image *image = jbig2_page_out(ctx.get());
+    if (!image)
+        fail(state, "no page in JBIG2 data");
+
+    // jbig2dec uses 1 for black, and /JBIG2Decode 0 for black, as DeviceGray does.
+    // Padding bits at the end of each row are left as 0.
+    size_t row_bytes = (static_cast<size_t>(image->width) + 7) / 8;
+    unsigned char last_mask = 0xff;
+    if (auto tail = image->width % 8)
+        last_mask = static_cast<unsigned char>(0xff << (8 - tail));
+    std::string result(row_bytes * image->height, '\0');
+    for (uint32_t y = 0; y < image->height; ++y) {
+        auto *src = image->data + static_cast<size_t>(y) * image->stride;
+        auto *dst = reinterpret_cast<unsigned char *>(result.data()) + y * row_bytes;
+        for (size_t x = 0; x < row_bytes; ++x)
+            dst[x] = static_cast<unsigned char>(~src[x]);
+        if (row_bytes > 0)
+            dst[row_bytes - 1] &= last_mask;
+    }
+    jbig2_release_page(ctx.get(), image);
+    return result;
+}
+#else
+std::string jbig2dec_decode(std::string const &, std::string const &)
+{
+    throw std::runtime_error("pikepdf was not built with libjbig2dec");
+}
+#endif
+
+bool jbig2_native_decoding()
+{
+    return native_decoding.load(std::memory_order_relaxed);
+}
+
+void set_jbig2_native_decoding(bool enabled)
+{
+    if (enabled && !jbig2dec_native_available())
+        throw std::invalid_argument("pikepdf was not built with libjbig2dec");
+    native_decoding.store(enabled, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const std::string> jbig2_globals_data(QPDFObjectHandle globals)
+{
+    auto key = globals_key(globals);
+    if (key) {
+        std::lock_guard<std::mutex> lock(globals_data_mutex);
+        if (auto *found = globals_data_cache.find(*key)) {
+            data_hits++;
+            return *found;
+        }
+    }
+    data_misses++;
+
+    // Not under the lock, since reading may call into Python
+    auto buf = globals.getStreamData();
+    auto data = std::make_shared<const std::string>(
+        reinterpret_cast<char *>(buf->getBuffer()), buf->getSize());
+    if (key) {
+        std::lock_guard<std::mutex> lock(globals_data_mutex);
+        globals_data_cache.insert(*key, data);
+    }
+    return data;
+}
+
+void jbig2_globals_forget(QPDFObjectHandle &stream)
+{
+    if (auto key = globals_key(stream)) {
+        std::lock_guard<std::mutex> lock(globals_data_mutex);
+        globals_data_cache.erase(*key);
+    }
+}
+
+Jbig2CacheStats jbig2_cache_stats()
+{
+    Jbig2CacheStats stats;
+    stats.data_hits = data_hits.load();
+    stats.data_misses = data_misses.load();
+    stats.parse_hits = parse_hits.load();
+    stats.parse_misses = parse_misses.load();
+    return stats;
+}
+
+void jbig2_cache_clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(globals_data_mutex);
+        globals_data_cache.clear();
+    }
+#ifdef PIKEPDF_WITH_JBIG2DEC
+    parsed_globals.clear();
+#endif
+    data_hits = 0;
+    data_misses = 0;
+    parse_hits = 0;
+    parse_misses = 0;
+}
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <qpdf/QPDFObjectHandle.hh>
+
+// JBIG2 decoding in process with libjbig2dec, when pikepdf is built with it
+// (PIKEPDF_WITH_JBIG2DEC). Otherwise /JBIG2Decode is handled by the Python decoder
+// from pikepdf.jbig2, which runs the jbig2dec program.
+
+// True if pikepdf was built with libjbig2dec.
+bool jbig2dec_native_available();
+
+// Decode an embedded JBIG2 stream, and its optional globals, to the 1 bit per
+// pixel rows that /JBIG2Decode produces, where 0 is black. Thread-safe and does
+// not call into Python. Throws std::runtime_error if the data cannot be decoded.
+//
+// Each thread keeps the parsed state of the last few globals it was given, so
+// consecutive images that share globals, such as the pages of a scanned book, do
+// not parse them again.
+std::string jbig2dec_decode(std::string const &data, std::string const &globals);
+
+// Whether /JBIG2Decode uses jbig2dec_decode() instead of calling into Python. Set
+// by pikepdf.jbig2.set_decoder(); only ever true if the native decoder is
+// available.
+bool jbig2_native_decoding();
+void set_jbig2_native_decoding(bool enabled);
+
+// The decoded data of a /JBIG2Globals stream, cached by QPDF and object, so that
+// the many image streams sharing it do not each decode it again. Thread-safe.
+std::shared_ptr<const std::string> jbig2_globals_data(QPDFObjectHandle globals);
+
+// Drop any cached data for a stream, because its data is being replaced.
+void jbig2_globals_forget(QPDFObjectHandle &stream);
+
+struct Jbig2CacheStats {
+    // Lookups of /JBIG2Globals stream data
+    size_t data_hits = 0;
+    size_t data_misses = 0;
+    // Lookups of parsed globals by the native decoder, for all threads
+    size_t parse_hits = 0;
+    size_t parse_misses = 0;
+};
+
+Jbig2CacheStats jbig2_cache_stats();
+
+// Empty the stream data cache, and the calling thread's parsed globals, and reset
+// the counters.
+void jbig2_cache_clear();
@@ -1,7 +1,9 @@
 // SPDX-FileCopyrightText: 2022 James R. Barlow
 // SPDX-License-Identifier: MPL-2.0
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <qpdf/QPDFJob.hh>
 #include <streambuf>
 
@@ -9,24 +11,63 @@
 #include <pybind11/stl.h>
 
 #include "pikepdf.h"
+#include "progress.h"
 
-void set_job_defaults(QPDFJob &job)
+// QPDFJob cannot report whether --progress was configured, which is needed to put
+// progress reporting back the way it was after a run with a progress callback, so
+// pikepdf's Job remembers it.
+class PikeJob : public QPDFJob {
+public:
+    bool progress_configured = false;
+};
+
+void set_job_defaults(PikeJob &job)
 {
     job.setMessagePrefix("pikepdf");
 }
 
-QPDFJob job_from_json_str(const std::string &json)
+PikeJob job_from_json_str(const std::string &json)
 {
-    QPDFJob job;
+    PikeJob job;
     bool partial = false;
     job.initializeFromJson(json, partial);
     set_job_defaults(job);
+    auto json_dict = py::module_::import("json").attr("loads")(json);
+    job.progress_configured =
+        py::isinstance<py::dict>(json_dict) && json_dict.contains("progress");
     return job;
 }
 
+// Reports a job's progress to reporter for the duration of one run, then restores
+// the reporter the job had before: qpdf's default of printing progress if the job
+// was configured with --progress, otherwise none. QPDFJob has no way to turn
+// progress reporting off again, so "none" is a function that ignores it.
+class ScopedJobProgress {
+public:
+    ScopedJobProgress(PikeJob &job, std::shared_ptr<PikeProgressReporter> reporter)
+        : job(job)
+    {
+        this->job.registerProgressReporter(
+            [reporter](int percent) { reporter->reportProgress(percent); });
+        this->job.config()->progress();
+    }
+    ~ScopedJobProgress()
+    {
+        if (this->job.progress_configured)
+            this->job.registerProgressReporter(std::function<void(int)>());
+        else
+            this->job.registerProgressReporter([](int) {});
+    }
+    ScopedJobProgress(const ScopedJobProgress &) = delete;
+    ScopedJobProgress &operator=(const ScopedJobProgress &) = delete;
+
+private:
+    PikeJob &job;
+};
+
 void init_job(py::module_ &m)
 {
-    py::class_<QPDFJob, py::smart_holder>(m, "Job")
+    py::class_<PikeJob, py::smart_holder>(m, "Job")
         .def_static(
             "json_out_schema",
             [](int schema = JSON::LATEST) { return QPDFJob::json_out_schema(schema); },
@@ -56,7 +97,7 @@ void init_job(py::module_ &m)
             py::arg("json_dict"))
         .def(py::init(
                  [](const std::vector<std::string> &args, std::string const &progname) {
-                     QPDFJob job;
+                     PikeJob job;
                      std::vector<const char *> cstrings;
                      cstrings.reserve(args.size() + 1);
 
@@ -67,6 +108,9 @@ void init_job(py::module_ &m)
 
                      job.initializeFromArgv(cstrings.data(), progname.c_str());
                      set_job_defaults(job);
+                     job.progress_configured =
+                         std::find(args.begin(), args.end(), "--progress") !=
+                         args.end();
                      return job;
                  }),
             py::arg("args"),
@@ -78,13 +122,26 @@ void init_job(py::module_ &m)
             )
         .def_property(
             "message_prefix", &QPDFJob::getMessagePrefix, &QPDFJob::setMessagePrefix)
-        .def("run", &QPDFJob::run)
+        .def(
+            "run",
+            [](PikeJob &job, py::object progress_event, py::object cancellation_token) {
+                auto token = get_cancellation_token(cancellation_token);
+                std::optional<ScopedJobProgress> scoped_progress;
+                if (!progress_event.is_none() || token)
+                    scoped_progress.emplace(job,
+                        std::make_shared<PikeProgressReporter>(
+                            py::none(), progress_event, token, "job"));
+                job.run();
+            },
+            py::kw_only(),
+            py::arg("progress_event") = py::none(),
+            py::arg("cancellation_token") = py::none())
         .def("create_pdf",
-            [](QPDFJob &job) { return std::shared_ptr<QPDF>(job.createQPDF()); })
+            [](PikeJob &job) { return std::shared_ptr<QPDF>(job.createQPDF()); })
         .def("write_pdf", &QPDFJob::writeQPDF, py::arg("pdf"))
         .def_property_readonly("has_warnings", &QPDFJob::hasWarnings)
         .def_property_readonly("exit_code", &QPDFJob::getExitCode)
-        .def_property_readonly("encryption_status", [](QPDFJob &job) {
+        .def_property_readonly("encryption_status", [](PikeJob &job) {
             uint bits = job.getEncryptionStatus();
             py::dict result;
             result["encrypted"] = bool(bits & qpdf_es_encrypted);
@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: 2022 James R. Barlow
 // SPDX-License-Identifier: MPL-2.0
 
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
 
@@ -21,6 +22,18 @@
 #include "utils.h"
 #include <signal.h>
 
+#if !defined(_WIN32)
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <sys/types.h>
+#endif
+
+// Access pattern hints that may be passed to the kernel for a memory mapping.
+enum class access_advice_e {
+    random,     // Opening, xref parsing and object resolution
+    sequential, // Whole document passes, such as saving
+};
+
 // We could almost subclass BufferInputSource here, except that it expects Buffer
 // as an initialization parameter, we don't know what the buffer location is until
 // the mmap is set up. Instead, this class is an InputSource that has a
@@ -30,6 +43,10 @@
 // of InputSource::last_offset by copying it whenever may change. If the design of
 // InputSource changes to introduce other state variables, we need to replicate the
 // BufferInputSource's state.
+//
+// On POSIX we map the file ourselves, so that we can give the kernel access pattern
+// hints with madvise(). Elsewhere we use Python's mmap module, since it is more
+// portable than platform versions.
 
 // GIL usage:
 // The GIL must be held while this class is constructed, by the constructor's caller,
@@ -54,10 +71,50 @@ public:
 
         py::int_ fileno = this->stream.attr("fileno")();
         int fd = fileno;
+
+#if !defined(_WIN32)
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, description.c_str());
+            throw py::error_already_set();
+        }
+        if (st.st_size == 0) {
+            // Same error as Python's mmap module
+            PyErr_SetString(PyExc_ValueError, "cannot mmap an empty file");
+            throw py::error_already_set();
+        }
+        this->map_size = static_cast<size_t>(st.st_size);
+
+        int flags = MAP_SHARED;
+#    if defined(MAP_POPULATE)
+        if (this->map_size <= get_mmap_populate_threshold())
+            flags |= MAP_POPULATE;
+#    endif
+        void *addr = ::mmap(nullptr, this->map_size, PROT_READ, flags, fd, 0);
+        if (addr == MAP_FAILED) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, description.c_str());
+            throw py::error_already_set();
+        }
+        this->map_addr = addr;
+        this->advise(access_advice_e::random);
+
+        try {
+            auto qpdf_buffer = std::make_unique<Buffer>(
+                static_cast<unsigned char *>(this->map_addr), this->map_size);
+            this->bis = std::make_unique<BufferInputSource>(description,
+                qpdf_buffer.release(),
+                false // own_memory=false
+            );
+        } catch (...) {
+            // The destructor does not run if the constructor throws
+            ::munmap(this->map_addr, this->map_size);
+            this->map_addr = nullptr;
+            throw;
+        }
+#else
         auto mmap_module = py::module_::import("mmap");
         auto mmap_fn = mmap_module.attr("mmap");
 
-        // Use Python's mmap API since it is more portable than platform versions.
         auto access_read = mmap_module.attr("ACCESS_READ");
         this->mmap = mmap_fn(fd, 0, py::arg("access") = access_read);
         py::buffer view(this->mmap);
@@ -74,19 +131,27 @@ public:
             qpdf_buffer.release(),
             false // own_memory=false
         );
+#endif
     }
     virtual ~MmapInputSource()
     {
         py::gil_scoped_acquire acquire;
         try {
+            this->bis.reset();
+#if !defined(_WIN32)
+            if (this->map_addr != nullptr) {
+                ::munmap(this->map_addr, this->map_size);
+                this->map_addr = nullptr;
+            }
+#else
             // buffer_info.reset() will trigger PyBuffer_Release(), which we must
             // do before we can close the memory mapping, since we exported a pointer
             // from it.
-            this->bis.reset();
             this->buffer_info.reset();
             if (!this->mmap.is_none()) {
                 this->mmap.attr("close")();
             }
+#endif
 
             if (this->close_stream && py::hasattr(this->stream, "close")) {
                 this->stream.attr("close")();
@@ -107,6 +172,25 @@ public:
     MmapInputSource &operator=(MmapInputSource &&) = delete;
     // LCOV_EXCL_STOP
 
+    // Tell the kernel how we are about to access the mapping. Hints are advisory,
+    // so failures are ignored. Does not require the GIL.
+    void advise(access_advice_e advice)
+    {
+#if !defined(_WIN32)
+        if (this->map_addr == nullptr)
+            return;
+        switch (advice) {
+        case access_advice_e::random:
+            (void)::madvise(this->map_addr, this->map_size, MADV_RANDOM);
+            break;
+        case access_advice_e::sequential:
+            (void)::madvise(this->map_addr, this->map_size, MADV_SEQUENTIAL);
+            (void)::madvise(this->map_addr, this->map_size, MADV_WILLNEED);
+            break;
+        }
+#endif
+    }
+
     std::string const &getName() const override { return this->bis->getName(); }
 
     qpdf_offset_t tell() override
@@ -154,7 +238,12 @@ public:
 private:
     py::object stream;
     bool close_stream;
+#if !defined(_WIN32)
+    void *map_addr = nullptr;
+    size_t map_size = 0;
+#else
     py::object mmap;
     std::unique_ptr<py::buffer_info> buffer_info;
+#endif
     std::unique_ptr<BufferInputSource> bis;
 };
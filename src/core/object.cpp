@@ -23,8 +23,10 @@
 #include "pikepdf.h"
 #include "utils.h"
 
+#include "jbig2dec.h"
 #include "namepath.h"
 #include "parsers.h"
+#include "streamcache.h"
 
 /*
 Type table
@@ -197,6 +199,31 @@ std::shared_ptr<Buffer> get_stream_data(
     }
 }
 
+// As get_stream_data(), but using the owning Pdf's decoded stream cache, if it
+// has one. The data returned may be shared with the cache, so must not be changed.
+std::shared_ptr<Buffer> get_stream_data_cached(
+    QPDFObjectHandle &h, qpdf_stream_decode_level_e decode_level)
+{
+    auto cache = h.isStream() ? get_decoded_stream_cache(h) : nullptr;
+    if (!cache)
+        return get_stream_data(h, decode_level);
+    if (auto data = cache->get(h, decode_level))
+        return data;
+    auto data = get_stream_data(h, decode_level);
+    cache->put(h, decode_level, data);
+    return data;
+}
+
+// Return stream data as bytes, or if not copy, as a read-only memoryview that
+// keeps the Buffer alive. py::bytes makes a copy, so releasing buf is fine.
+py::object stream_buffer_to_python(std::shared_ptr<Buffer> buf, bool copy)
+{
+    if (copy)
+        return py::bytes((const char *)buf->getBuffer(), buf->getSize());
+    auto view = py::memoryview(py::cast(std::move(buf)));
+    return view.attr("toreadonly")();
+}
+
 void init_object(py::module_ &m)
 {
     py::enum_<qpdf_object_type_e>(m, "ObjectType")
@@ -1165,17 +1192,27 @@ void init_object(py::module_ &m)
             [](QPDFObjectHandle &h) { return h.getRawStreamData(); })
         .def(
             "read_bytes",
-            [](QPDFObjectHandle &h, qpdf_stream_decode_level_e decode_level) {
-                auto buf = get_stream_data(h, decode_level);
-                return py::bytes((const char *)buf->getBuffer(), buf->getSize());
+            [](QPDFObjectHandle &h,
+                qpdf_stream_decode_level_e decode_level,
+                bool copy) {
+                return stream_buffer_to_python(
+                    get_stream_data_cached(h, decode_level), copy);
             },
-            py::arg("decode_level") = qpdf_dl_generalized)
-        .def("read_raw_bytes",
-            [](QPDFObjectHandle &h) {
-                auto buf = h.getRawStreamData();
-                // py::bytes will make a copy of the buffer, so releasing is fine
-                return py::bytes((const char *)buf->getBuffer(), buf->getSize());
-            })
+            py::arg("decode_level") = qpdf_dl_generalized,
+            py::kw_only(),
+            py::arg("copy") = true)
+        .def(
+            "read_raw_bytes",
+            [](QPDFObjectHandle &h, bool copy) {
+                return stream_buffer_to_python(h.getRawStreamData(), copy);
+            },
+            py::kw_only(),
+            py::arg("copy") = true)
+        .def("_detach_decoder",
+            detach_decoder,
+            py::arg("decode_level"),
+            "Read the stream's raw data, and return a function that decodes it "
+            "into a queue on any thread, or None if it must be decoded in place.")
         .def(
             "_write",
             [](QPDFObjectHandle &h,
@@ -1186,6 +1223,9 @@ void init_object(py::module_ &m)
                 QPDFObjectHandle h_filter = objecthandle_encode(filter);
                 QPDFObjectHandle h_decode_parms = objecthandle_encode(decode_parms);
                 h.replaceStreamData(sdata, h_filter, h_decode_parms);
+                jbig2_globals_forget(h);
+                if (auto *owner = h.getOwningQPDF())
+                    forget_decoded_stream(*owner, h.getObjGen());
             },
             py::arg("data"),
             py::arg("filter"),
@@ -8,6 +8,8 @@
 
 #include "parsers.h"
 #include "pikepdf.h"
+#include "qpdf_pagelist.h"
+#include "streamcache.h"
 
 #include <qpdf/Pipeline.hh>
 #include <qpdf/Pl_Buffer.hh>
@@ -60,6 +62,26 @@ void init_page(py::module_ &m)
         .def("_get_bleedbox", &QPDFPageObjectHelper::getBleedBox)
         .def("_get_cropbox", &QPDFPageObjectHelper::getCropBox)
         .def("_get_trimbox", &QPDFPageObjectHelper::getTrimBox)
+        .def_property_readonly("_lazy_inheritance",
+            [](QPDFPageObjectHelper &poh) {
+                auto *owner = poh.getObjectHandle().getOwningQPDF();
+                return owner && has_lazy_page_attributes(*owner);
+            })
+        .def(
+            "_lazy_inherited_attribute",
+            [](QPDFPageObjectHelper &poh, std::string const &key, bool copy) {
+                // In a Pdf with lazy page attributes, what the page would have had
+                // if they had been pushed to the pages when it was opened
+                auto oh = poh.getObjectHandle();
+                auto *owner = oh.getOwningQPDF();
+                if (!owner || !has_lazy_page_attributes(*owner))
+                    return QPDFObjectHandle::newNull();
+                auto value = inherited_page_attribute(oh, key);
+                // As QPDF::pushInheritedAttributesToPage() would copy it to the page
+                return copy && !value.isIndirect() ? value.shallowCopy() : value;
+            },
+            py::arg("key"),
+            py::arg("copy") = false)
         .def(
             "externalize_inline_images",
             [](QPDFPageObjectHelper &poh, size_t min_size = 0, bool shallow = false) {
@@ -156,6 +178,12 @@ void init_page(py::module_ &m)
                 py::detail::keep_alive_impl(pyqpdf, pytf);
 
                 poh.addContentTokenFilter(tf);
+                // The filtered stream now decodes differently
+                auto oh = poh.getObjectHandle();
+                auto filtered = oh.isStream() ? oh : oh.getKey("/Contents");
+                if (filtered.isStream() && filtered.isIndirect())
+                    forget_decoded_stream(
+                        *filtered.getOwningQPDF(), filtered.getObjGen());
             },
             py::arg("tf"))
         .def(
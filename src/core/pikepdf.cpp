@@ -24,6 +24,10 @@
 #include <pybind11/iostream.h>
 #include <pybind11/stl.h>
 
+#include "cancellation.h"
+#include "flate_backend.h"
+#include "imagekernels.h"
+#include "jbig2dec.h"
 #include "namepath.h"
 #include "parsers.h"
 #include "qpdf_pagelist.h"
@@ -32,6 +36,13 @@
 static constinit std::atomic<uint> DECIMAL_PRECISION = 15;
 static constinit std::atomic<bool> MMAP_DEFAULT = false;
 static constinit std::atomic<bool> EXPLICIT_CONVERSION_MODE = false;
+static constinit std::atomic<size_t> STREAM_CACHE_BLOCK_SIZE = 64 * 1024;
+static constinit std::atomic<size_t> STREAM_CACHE_BLOCKS = 16;
+static constinit std::atomic<size_t> MMAP_POPULATE_THRESHOLD = 0;
+static constinit std::atomic<size_t> OUTPUT_BUFFER_SIZE = 1024 * 1024;
+// Mirrors the level last given to Pl_Flate::setCompressionLevel, which qpdf does
+// not let us read back
+static constinit std::atomic<int> FLATE_COMPRESSION_LEVEL = -1;
 
 // Thread-local counter for explicit_conversion() context manager nesting.
 // When > 0, the current thread is inside one or more context managers and
@@ -46,6 +57,26 @@ bool get_mmap_default()
 {
     return MMAP_DEFAULT.load();
 }
+size_t get_mmap_populate_threshold()
+{
+    return MMAP_POPULATE_THRESHOLD.load();
+}
+size_t get_output_buffer_size()
+{
+    return OUTPUT_BUFFER_SIZE.load();
+}
+int get_flate_compression_level()
+{
+    return FLATE_COMPRESSION_LEVEL.load();
+}
+size_t get_stream_cache_block_size()
+{
+    return STREAM_CACHE_BLOCK_SIZE.load();
+}
+size_t get_stream_cache_blocks()
+{
+    return STREAM_CACHE_BLOCKS.load();
+}
 bool get_explicit_conversion_mode()
 {
     // Thread-local context manager takes precedence over global setting
@@ -144,6 +175,17 @@ bool is_object_type_assertion_error(const std::runtime_error &e)
     return std::regex_search(e.what(), error_pattern);
 }
 
+// Request a buffer as contiguous bytes, for the image kernels
+py::buffer_info request_bytes(py::buffer buf, bool writable = false)
+{
+    auto info = buf.request(writable);
+    bool contiguous =
+        info.ndim == 0 || (info.ndim == 1 && info.strides[0] == info.itemsize);
+    if (info.itemsize != 1 || !contiguous)
+        throw py::value_error("expected a contiguous buffer of bytes");
+    return info;
+}
+
 PYBIND11_MODULE(_core, m, py::mod_gil_not_used())
 {
     // py::options options;
@@ -154,6 +196,7 @@ PYBIND11_MODULE(_core, m, py::mod_gil_not_used())
     m.def("qpdf_version", &QPDF::QPDFVersion, "Get libqpdf version");
 
     // -- Core objects --
+    init_flate_backends();
     init_logger(m);
     init_qpdf(m);
     init_pagelist(m);
@@ -210,6 +253,54 @@ PYBIND11_MODULE(_core, m, py::mod_gil_not_used())
             "set_access_default_mmap",
             [](bool mmap) { return MMAP_DEFAULT.exchange(mmap); },
             "If True, ``pikepdf.open(...access_mode=access_default)`` will use mmap.")
+        .def(
+            "get_mmap_populate_threshold",
+            []() { return MMAP_POPULATE_THRESHOLD.load(); },
+            "Return the largest file size that is prefaulted when memory mapped.")
+        .def(
+            "set_mmap_populate_threshold",
+            [](size_t nbytes) { return MMAP_POPULATE_THRESHOLD.exchange(nbytes); },
+            py::arg("nbytes"),
+            "Prefault memory mapped files up to this size (Linux only).")
+        .def(
+            "get_stream_read_cache",
+            []() {
+                return py::make_tuple(
+                    STREAM_CACHE_BLOCK_SIZE.load(), STREAM_CACHE_BLOCKS.load());
+            },
+            "Return (block_size, max_blocks) of the stream read cache.")
+        .def(
+            "set_stream_read_cache",
+            [](size_t block_size, size_t max_blocks) {
+                if (block_size < 512)
+                    throw py::value_error("block_size must be at least 512 bytes");
+                auto previous = py::make_tuple(
+                    STREAM_CACHE_BLOCK_SIZE.exchange(block_size),
+                    STREAM_CACHE_BLOCKS.exchange(max_blocks));
+                return previous;
+            },
+            py::arg("block_size") = 64 * 1024,
+            py::arg("max_blocks") = 16,
+            "Configure the block cache used when reading PDFs from Python streams.")
+        .def(
+            "get_output_buffer_size",
+            []() { return OUTPUT_BUFFER_SIZE.load(); },
+            "Return the size of the buffer used when saving PDFs to Python streams.")
+        .def(
+            "set_output_buffer_size",
+            [](size_t nbytes) { return OUTPUT_BUFFER_SIZE.exchange(nbytes); },
+            py::arg("nbytes") = 1024 * 1024,
+            "Set the size of the buffer used when saving PDFs to Python streams.")
+        .def("get_flate_backend",
+            &get_flate_backend_name,
+            "Return the name of the flate implementation in use.")
+        .def("get_flate_backends",
+            &flate_backend_names,
+            "Return the names of the available flate implementations.")
+        .def("set_flate_backend",
+            &set_flate_backend,
+            py::arg("name"),
+            "Select the flate implementation used to compress and decompress streams.")
         .def(
             "_get_explicit_conversion_mode",
             []() { return EXPLICIT_CONVERSION_MODE.load(); },
@@ -238,12 +329,88 @@ PYBIND11_MODULE(_core, m, py::mod_gil_not_used())
             [](int level) {
                 if (-1 <= level && level <= 9) {
                     Pl_Flate::setCompressionLevel(level);
+                    FLATE_COMPRESSION_LEVEL = level;
                     return level;
                 }
                 throw py::value_error(
                     "Flate compression level must be between 0 and 9 (or -1)");
             })
-        .def("_unparse_content_stream", unparse_content_stream);
+        .def("_unparse_content_stream", unparse_content_stream)
+        .def("_jbig2dec_native_available",
+            &jbig2dec_native_available,
+            "Return True if pikepdf was built with libjbig2dec.")
+        .def(
+            "_per_stream_compression_levels",
+            []() { return get_zlib_level_backend() != nullptr; },
+            "Return True if streams can be compressed at their own levels with zlib.")
+        .def("_jbig2dec_decode",
+            [](py::bytes data, py::bytes globals) {
+                std::string sdata = data, sglobals = globals;
+                std::string decoded;
+                {
+                    py::gil_scoped_release release;
+                    decoded = jbig2dec_decode(sdata, sglobals);
+                }
+                return py::bytes(decoded);
+            })
+        .def("_jbig2_cache_stats",
+            []() {
+                auto stats = jbig2_cache_stats();
+                py::dict result;
+                result["data_hits"] = stats.data_hits;
+                result["data_misses"] = stats.data_misses;
+                result["parse_hits"] = stats.parse_hits;
+                result["parse_misses"] = stats.parse_misses;
+                return result;
+            })
+        .def("_jbig2_cache_clear", &jbig2_cache_clear)
+        .def("_set_jbig2_native_decoding",
+            &set_jbig2_native_decoding,
+            "Decode /JBIG2Decode with libjbig2dec instead of calling into Python.")
+        .def(
+            "_unpack_subbyte_pixels",
+            [](py::buffer packed, py::buffer out, int bits, double scale, bool invert) {
+                auto in_info = request_bytes(packed);
+                auto out_info = request_bytes(out, true);
+                py::gil_scoped_release release;
+                unpack_subbyte_pixels(static_cast<unsigned char const *>(in_info.ptr),
+                    static_cast<size_t>(in_info.size),
+                    static_cast<unsigned char *>(out_info.ptr),
+                    static_cast<size_t>(out_info.size),
+                    bits,
+                    scale,
+                    invert);
+            },
+            "Unpack 1, 2 or 4 bit samples from packed into one byte each in out.")
+        .def(
+            "_expand_palette",
+            [](py::buffer packed,
+                py::buffer out,
+                size_t width,
+                size_t height,
+                int bits,
+                py::buffer palette,
+                int components) {
+                auto in_info = request_bytes(packed);
+                auto out_info = request_bytes(out, true);
+                auto palette_info = request_bytes(palette);
+                auto size = expanded_palette_size(width, height, components);
+                if (static_cast<size_t>(out_info.size) < size)
+                    throw py::value_error("output buffer is too small: needs " +
+                                          std::to_string(size) + " bytes");
+                py::gil_scoped_release release;
+                expand_palette(static_cast<unsigned char const *>(in_info.ptr),
+                    static_cast<size_t>(in_info.size),
+                    width,
+                    height,
+                    bits,
+                    static_cast<unsigned char const *>(palette_info.ptr),
+                    static_cast<size_t>(palette_info.size),
+                    components,
+                    static_cast<unsigned char *>(out_info.ptr));
+            },
+            "Look up each index of an Indexed image in palette, writing to out.")
+        .def("_image_kernel_isa", &image_kernel_isa);
 
     // -- Exceptions --
     // clang-format off
@@ -265,11 +432,18 @@ PYBIND11_MODULE(_core, m, py::mod_gil_not_used())
     PYBIND11_CONSTINIT static py::gil_safe_call_once_and_store<py::object> exc_destroyedobject;
     exc_destroyedobject.call_once_and_store_result(
         [&]() { return py::exception<std::runtime_error>(m, "DeletedObjectError"); });
+    PYBIND11_CONSTINIT static py::gil_safe_call_once_and_store<py::object> exc_cancelled;
+    exc_cancelled.call_once_and_store_result([&]() {
+        return py::exception<OperationCancelled>(
+            m, "OperationCancelledError", exc_main.get_stored());
+    });
     // clang-format on
     py::register_exception_translator([](std::exception_ptr p) {
         try {
             if (p)
                 std::rethrow_exception(p);
+        } catch (const OperationCancelled &e) {
+            py::set_error(exc_cancelled.get_stored(), e.what());
         } catch (const QPDFExc &e) {
             if (e.getErrorCode() == qpdf_e_password) {
                 py::set_error(exc_password.get_stored(), e.what());
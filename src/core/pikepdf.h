@@ -28,8 +28,43 @@ pybind11::object decimal_from_pdfobject(QPDFObjectHandle h);
 // From pikepdf.cpp - forward declaration for type_caster
 bool get_explicit_conversion_mode();
 
+// From qpdf.cpp - forward declaration for type_caster
+// Throws if q (which may be null) is being saved by another thread, such as the
+// background thread of Pdf.iter_save(), since QPDF is not thread-safe and the save
+// runs without the GIL.
+void check_pdf_available(QPDF *q);
+
+inline QPDF *owning_pdf(QPDF &q) { return &q; }
+inline QPDF *owning_pdf(QPDFObjectHandle &h) { return h.getOwningQPDF(); }
+inline QPDF *owning_pdf(QPDFObjectHelper &helper)
+{
+    return helper.getObjectHandle().getOwningQPDF();
+}
+
 namespace pybind11 {
 namespace detail {
+// Loads a Pdf, or a helper belonging to one, only if the Pdf is not being saved by
+// another thread.
+template <typename T>
+struct pdf_checked_caster : public type_caster_base<T> {
+    using base = type_caster_base<T>;
+
+    bool load(handle src, bool convert)
+    {
+        if (!base::load(src, convert))
+            return false;
+        if (base::value)
+            check_pdf_available(owning_pdf(*static_cast<T *>(base::value)));
+        return true;
+    }
+};
+
+template <>
+struct type_caster<QPDF> : public pdf_checked_caster<QPDF> {};
+template <>
+struct type_caster<QPDFPageObjectHelper>
+    : public pdf_checked_caster<QPDFPageObjectHelper> {};
+
 template <>
 struct type_caster<QPDFObjectHandle> : public type_caster_base<QPDFObjectHandle> {
     using base = type_caster_base<QPDFObjectHandle>;
@@ -46,7 +81,12 @@ public:
         // Do whatever our base does
         // Potentially we could convert some scalars to QPDFObjectHandle here,
         // but most of the interfaces just expect straight C++ types.
-        return base::load(src, convert);
+        if (!base::load(src, convert))
+            return false;
+        if (base::value)
+            check_pdf_available(
+                owning_pdf(*static_cast<QPDFObjectHandle *>(base::value)));
+        return true;
     }
 
     /**
@@ -128,6 +168,7 @@ PYBIND11_MAKE_OPAQUE(ObjectMap);
 
 // From qpdf.cpp
 void init_qpdf(py::module_ &m);
+void forget_replaced_object(QPDF &q, QPDFObjGen og);
 
 // From object.cpp
 size_t list_range_check(QPDFObjectHandle h, int index);
@@ -152,6 +193,8 @@ std::map<std::string, QPDFObjectHandle> dict_builder(const py::dict dict);
 void init_acroform(py::module_ &m);
 // From annotation.cpp
 void init_annotation(py::module_ &m);
+// From dedupe.cpp
+py::dict deduplicate_streams(QPDF &q);
 // From embeddedfiles.cpp
 void init_embeddedfiles(py::module_ &m);
 // From job.cpp
@@ -174,10 +217,24 @@ void init_parsers(py::module_ &m);
 void init_rectangle(py::module_ &m);
 // From tokenfilter.cpp
 void init_tokenfilter(py::module_ &m);
+// From decodepool.cpp
+py::list validate_streams(QPDF &q, int threads, py::object cancellation_token);
+py::list read_streams(QPDF &q,
+    std::vector<QPDFObjectHandle> objects,
+    qpdf_stream_decode_level_e decode_level,
+    int threads);
+py::object detach_decoder(QPDFObjectHandle &stream, qpdf_stream_decode_level_e level);
+// From imagescan.cpp
+py::list collect_images(QPDF &q);
 
 // pikepdf.cpp
 uint get_decimal_precision();
 bool get_mmap_default();
+size_t get_mmap_populate_threshold();
+size_t get_output_buffer_size();
+int get_flate_compression_level();
+size_t get_stream_cache_block_size();
+size_t get_stream_cache_blocks();
 bool get_explicit_conversion_mode();
 
 inline void python_warning(const char *msg, PyObject *category = PyExc_UserWarning)
@@ -1,6 +1,14 @@
 // SPDX-FileCopyrightText: 2022 James R. Barlow
 // SPDX-License-Identifier: MPL-2.0
 
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#    include <unistd.h>
+#endif
+
 #include <qpdf/Constants.h>
 #include <qpdf/DLL.h>
 #include <qpdf/Pipeline.hh>
@@ -16,13 +24,48 @@
 #include "pipeline.h"
 #include "utils.h"
 
-void Pl_PythonOutput::write(const unsigned char *buf, size_t len)
+void Pl_BufferedOutput::write(const unsigned char *buf, size_t len)
+{
+    this->write_stats.chunks++;
+    this->write_stats.bytes += len;
+    if (this->buffer.size() + len <= this->buffer_size) {
+        this->buffer.insert(this->buffer.end(), buf, buf + len);
+        return;
+    }
+    this->flush_buffer();
+    if (len < this->buffer_size) {
+        this->buffer.insert(this->buffer.end(), buf, buf + len);
+    } else {
+        if (this->token)
+            this->token->check();
+        this->write_to_sink(buf, len);
+    }
+}
+
+void Pl_BufferedOutput::finish()
+{
+    this->flush_buffer();
+    this->finish_sink();
+}
+
+void Pl_BufferedOutput::flush_buffer()
+{
+    if (this->buffer.empty())
+        return;
+    if (this->token)
+        this->token->check();
+    this->write_to_sink(this->buffer.data(), this->buffer.size());
+    this->buffer.clear();
+}
+
+void Pl_PythonOutput::write_to_sink(const unsigned char *buf, size_t len)
 {
     py::gil_scoped_acquire gil;
     py::ssize_t so_far = 0;
     while (len > 0) {
         auto view_buffer = py::memoryview::from_memory(buf, len);
         py::object result = this->stream.attr("write")(view_buffer);
+        this->write_stats.stream_writes++;
         try {
             so_far = result.cast<py::ssize_t>();
         } catch (const py::cast_error &) {
@@ -40,8 +83,112 @@ void Pl_PythonOutput::write(const unsigned char *buf, size_t len)
     }
 }
 
-void Pl_PythonOutput::finish()
+void Pl_PythonOutput::finish_sink()
 {
     py::gil_scoped_acquire gil;
-    this->stream.attr("flush")();
+    // Write-only targets such as sockets and HTTP response bodies may not have it
+    if (py::hasattr(this->stream, "flush"))
+        this->stream.attr("flush")();
+}
+
+OutputChunkQueue::OutputChunkQueue(size_t chunk_size, size_t max_chunks)
+    : chunk_size_(chunk_size), max_chunks(max_chunks)
+{
+    if (chunk_size == 0 || max_chunks == 0)
+        throw std::invalid_argument("chunk_size and max_chunks must be at least 1");
+}
+
+void OutputChunkQueue::put(std::string chunk)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->space_available.wait(lock, [this] {
+        return this->cancelled || this->chunks.size() < this->max_chunks;
+    });
+    if (this->cancelled)
+        throw std::runtime_error("save cancelled: output is no longer being read");
+    this->chunks.push_back(std::move(chunk));
+    lock.unlock();
+    this->chunk_available.notify_one();
+}
+
+bool OutputChunkQueue::full()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return !this->cancelled && this->chunks.size() >= this->max_chunks;
+}
+
+void OutputChunkQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closed = true;
+    }
+    this->chunk_available.notify_all();
+}
+
+std::optional<std::string> OutputChunkQueue::get()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->chunk_available.wait(
+        lock, [this] { return this->closed || !this->chunks.empty(); });
+    if (this->chunks.empty())
+        return std::nullopt;
+    auto chunk = std::move(this->chunks.front());
+    this->chunks.pop_front();
+    lock.unlock();
+    this->space_available.notify_one();
+    return chunk;
+}
+
+void OutputChunkQueue::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->cancelled = true;
+        this->chunks.clear();
+    }
+    this->space_available.notify_all();
+}
+
+void Pl_ChunkQueueOutput::write_to_sink(const unsigned char *buf, size_t len)
+{
+    // Large writes bypass the buffer, so split them to keep chunks bounded
+    auto chunk_size = this->queue->chunk_size();
+    while (len > 0) {
+        auto n = std::min(len, chunk_size);
+        std::string chunk(reinterpret_cast<const char *>(buf), n);
+        if (PyGILState_Check() && this->queue->full()) {
+            // Savers and decoders normally run without the GIL, but if this one
+            // holds it, the consumer needs it to take chunks
+            py::gil_scoped_release release;
+            this->queue->put(std::move(chunk));
+        } else {
+            this->queue->put(std::move(chunk));
+        }
+        this->write_stats.stream_writes++;
+        buf += n;
+        len -= n;
+    }
+}
+
+void Pl_ChunkQueueOutput::finish_sink()
+{
+    this->queue->close();
+}
+
+#if !defined(_WIN32)
+void Pl_FileDescriptorOutput::write_to_sink(const unsigned char *buf, size_t len)
+{
+    while (len > 0) {
+        auto n = ::write(this->fd, buf, len);
+        this->write_stats.stream_writes++;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            QUtil::throw_system_error(this->identifier);
+        }
+        buf += n;
+        len -= static_cast<size_t>(n);
+    }
 }
+#endif
@@ -3,8 +3,15 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <qpdf/Buffer.hh>
 #include <qpdf/Constants.h>
@@ -18,24 +25,176 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "cancellation.h"
 #include "pikepdf.h"
 
-class Pl_PythonOutput : public Pipeline {
+// Base class for pipelines that deliver qpdf's output to its final destination.
+// QPDFWriter emits many small pieces, so they are collected in a buffer and passed
+// on in large chunks, to keep the number of calls into Python or the kernel down.
+class Pl_BufferedOutput : public Pipeline {
 public:
-    Pl_PythonOutput(const char *identifier, py::object stream)
-        : Pipeline(identifier, nullptr), stream(stream)
+    struct Stats {
+        size_t bytes = 0;         // Total bytes written
+        size_t chunks = 0;        // Calls to write() by qpdf
+        size_t stream_writes = 0; // Calls to stream.write() or write(2)
+    };
+
+    Pl_BufferedOutput(const char *identifier, size_t buffer_size)
+        : Pipeline(identifier, nullptr), buffer_size(buffer_size)
     {
+        this->buffer.reserve(this->buffer_size);
     }
 
-    virtual ~Pl_PythonOutput() = default;
-    Pl_PythonOutput(const Pl_PythonOutput &) = delete;
-    Pl_PythonOutput &operator=(const Pl_PythonOutput &) = delete;
-    Pl_PythonOutput(Pl_PythonOutput &&) = delete;
-    Pl_PythonOutput &operator=(Pl_PythonOutput &&) = delete;
+    virtual ~Pl_BufferedOutput() = default;
+    Pl_BufferedOutput(const Pl_BufferedOutput &) = delete;
+    Pl_BufferedOutput &operator=(const Pl_BufferedOutput &) = delete;
+    Pl_BufferedOutput(Pl_BufferedOutput &&) = delete;
+    Pl_BufferedOutput &operator=(Pl_BufferedOutput &&) = delete;
 
     void write(const unsigned char *buf, size_t len) override;
     void finish() override;
 
+    const Stats &stats() const { return this->write_stats; }
+
+    // Check this token before passing each chunk on, so that a write to a slow or
+    // stalled destination can be cancelled
+    void set_cancellation_token(std::shared_ptr<CancellationToken> token)
+    {
+        this->token = std::move(token);
+    }
+
+protected:
+    // Write all of buf to the destination
+    virtual void write_to_sink(const unsigned char *buf, size_t len) = 0;
+    // Called after the last write
+    virtual void finish_sink() {}
+
+    Stats write_stats;
+
+private:
+    void flush_buffer();
+
+    size_t buffer_size;
+    std::vector<unsigned char> buffer;
+    std::shared_ptr<CancellationToken> token;
+};
+
+// Writes qpdf output to a Python stream. Acquires the GIL whenever it calls into
+// Python, so the caller may release it.
+class Pl_PythonOutput : public Pl_BufferedOutput {
+public:
+    Pl_PythonOutput(const char *identifier,
+        py::object stream,
+        size_t buffer_size = get_output_buffer_size())
+        : Pl_BufferedOutput(identifier, buffer_size), stream(stream)
+    {
+    }
+    virtual ~Pl_PythonOutput() = default;
+
+protected:
+    void write_to_sink(const unsigned char *buf, size_t len) override;
+    void finish_sink() override;
+
 private:
     py::object stream;
 };
+
+// A bounded queue of output chunks, passed from a save running on one thread to a
+// consumer on another. The saving thread blocks while the queue is full, so the
+// memory held is bounded by the chunk size and capacity, however large the output.
+class OutputChunkQueue {
+public:
+    OutputChunkQueue(size_t chunk_size, size_t max_chunks);
+
+    size_t chunk_size() const { return this->chunk_size_; }
+
+    // Add a chunk, waiting while the queue is full. Throws if the consumer has
+    // cancelled, to abort the save.
+    void put(std::string chunk);
+    // Would put() wait? Only meaningful with a single producer.
+    bool full();
+    // No more chunks will be added. May be called more than once.
+    void close();
+    // Remove the next chunk, waiting until there is one. Returns nullopt once the
+    // queue is closed and empty.
+    std::optional<std::string> get();
+    // The consumer will not take any more chunks; discard any that are queued and
+    // make further calls to put() throw.
+    void cancel();
+
+private:
+    size_t chunk_size_;
+    size_t max_chunks;
+    std::mutex mutex;
+    std::condition_variable space_available;
+    std::condition_variable chunk_available;
+    std::deque<std::string> chunks;
+    bool closed = false;
+    bool cancelled = false;
+};
+
+// Writes qpdf output to an OutputChunkQueue, in chunks of the queue's chunk size
+// (except the last). Never calls into Python. If the writer holds the GIL, it is
+// released while waiting for space in the queue.
+class Pl_ChunkQueueOutput : public Pl_BufferedOutput {
+public:
+    Pl_ChunkQueueOutput(const char *identifier, std::shared_ptr<OutputChunkQueue> queue)
+        : Pl_BufferedOutput(identifier, queue->chunk_size()), queue(queue)
+    {
+    }
+    virtual ~Pl_ChunkQueueOutput() = default;
+
+protected:
+    void write_to_sink(const unsigned char *buf, size_t len) override;
+    void finish_sink() override;
+
+private:
+    std::shared_ptr<OutputChunkQueue> queue;
+};
+
+// Discards qpdf output, counting it and checking for cancellation as it goes. Used
+// to decode every stream without keeping the result.
+class Pl_DiscardOutput : public Pipeline {
+public:
+    Pl_DiscardOutput(
+        const char *identifier, std::shared_ptr<CancellationToken> token = nullptr)
+        : Pipeline(identifier, nullptr), token(std::move(token))
+    {
+    }
+    virtual ~Pl_DiscardOutput() = default;
+
+    void write(const unsigned char *, size_t len) override
+    {
+        if (this->token)
+            this->token->check();
+        this->bytes_ += len;
+    }
+    void finish() override {}
+
+    size_t bytes() const { return this->bytes_; }
+
+private:
+    std::shared_ptr<CancellationToken> token;
+    size_t bytes_ = 0;
+};
+
+#if !defined(_WIN32)
+// Writes qpdf output directly to a file descriptor, at its current position,
+// without involving Python or the GIL. The caller must keep the descriptor open,
+// and must flush any Python buffers for it before writing begins.
+class Pl_FileDescriptorOutput : public Pl_BufferedOutput {
+public:
+    Pl_FileDescriptorOutput(
+        const char *identifier, int fd, size_t buffer_size = get_output_buffer_size())
+        : Pl_BufferedOutput(identifier, buffer_size), fd(fd)
+    {
+    }
+    virtual ~Pl_FileDescriptorOutput() = default;
+
+protected:
+    void write_to_sink(const unsigned char *buf, size_t len) override;
+
+private:
+    int fd;
+};
+#endif
@@ -0,0 +1,320 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <qpdf/Pl_Flate.hh>
+#include <qpdf/Pl_String.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+#include "flate_backend.h"
+#include "precompress.h"
+#include "threadpool.h"
+
+namespace {
+
+// Would QPDFWriter compress this stream itself? Mirrors the writer's rules for the
+// cases we handle; anything else is left to the writer.
+bool should_precompress(QPDFObjectHandle &stream, bool recompress_flate)
+{
+    if (!stream.getFilterOnWrite())
+        return false;
+    auto dict = stream.getDict();
+    auto type = dict.getKey("/Type");
+    // The writer regenerates or drops xref and object streams, and leaves XMP
+    // metadata uncompressed so that it remains readable
+    if (type.isNameAndEquals("/XRef") || type.isNameAndEquals("/ObjStm") ||
+        type.isNameAndEquals("/Metadata"))
+        return false;
+    auto filter = dict.getKey("/Filter");
+    if (!recompress_flate &&
+        (filter.isNameAndEquals("/FlateDecode") || filter.isNameAndEquals("/Fl")))
+        return false;
+    return true;
+}
+
+// Classify a stream by its own dictionary, or else by how it was reached
+stream_class_e classify(QPDFObjectHandle &stream, stream_class_e reached_as)
+{
+    auto subtype = stream.getDict().getKey("/Subtype");
+    if (subtype.isNameAndEquals("/Image"))
+        return stream_class_e::image;
+    if (subtype.isNameAndEquals("/Form"))
+        return stream_class_e::content;
+    return reached_as;
+}
+
+// All streams reachable from the trailer, in a stable order, with their class
+std::vector<std::pair<QPDFObjectHandle, stream_class_e>> reachable_streams(QPDF &q)
+{
+    std::vector<std::pair<QPDFObjectHandle, stream_class_e>> streams;
+    QPDFObjGen::set visited;
+    std::vector<std::pair<QPDFObjectHandle, stream_class_e>> pending{
+        {q.getTrailer(), stream_class_e::other}};
+    while (!pending.empty()) {
+        auto [oh, reached_as] = pending.back();
+        pending.pop_back();
+        if (!visited.add(oh))
+            continue;
+        if (oh.isStream()) {
+            streams.emplace_back(oh, classify(oh, reached_as));
+            pending.emplace_back(oh.getDict(), stream_class_e::other);
+        } else if (oh.isDictionary()) {
+            for (auto const &key : oh.getKeys()) {
+                auto child_class = stream_class_e::other;
+                if (key == "/Contents")
+                    child_class = stream_class_e::content;
+                else if (key.starts_with("/FontFile"))
+                    child_class = stream_class_e::font;
+                pending.emplace_back(oh.getKey(key), child_class);
+            }
+        } else if (oh.isArray()) {
+            // Arrays pass on their class, for /Contents arrays
+            for (auto const &item : oh.getArrayAsVector())
+                pending.emplace_back(item, reached_as);
+        }
+    }
+    return streams;
+}
+
+int choose_level(CompressionPolicy const &policy, stream_class_e cls, size_t size)
+{
+    if (size >= policy.large_stream_size)
+        return policy.large_stream_level;
+    switch (cls) {
+    case stream_class_e::content:
+        return policy.content_level;
+    case stream_class_e::font:
+        return policy.font_level;
+    case stream_class_e::image:
+        return policy.image_level;
+    default:
+        return policy.other_level;
+    }
+}
+
+// Estimate the fraction of its size that compressing data would save, from the
+// order-0 entropy of a sample of its bytes. This is conservative for text-like data
+// such as content streams, which flate compresses better than the estimate, and
+// close to zero for data that is already compressed or random.
+double estimate_gain(std::string const &data, size_t sample_size)
+{
+    if (data.empty())
+        return 0.0;
+
+    std::array<size_t, 256> counts{};
+    auto count = [&](size_t start, size_t length) {
+        for (size_t i = start; i < start + length; ++i)
+            ++counts[static_cast<unsigned char>(data[i])];
+    };
+    if (sample_size == 0 || data.size() <= sample_size) {
+        count(0, data.size());
+    } else {
+        // Sample evenly spaced chunks, so a uniform header or trailer does not
+        // dominate the estimate
+        constexpr size_t chunks = 4;
+        size_t chunk = std::max<size_t>(sample_size / chunks, 1);
+        for (size_t i = 0; i < chunks; ++i)
+            count((data.size() - chunk) * i / (chunks - 1), chunk);
+    }
+
+    size_t total = std::accumulate(counts.begin(), counts.end(), size_t(0));
+    double entropy = 0.0;
+    for (auto n : counts) {
+        if (n == 0)
+            continue;
+        double p = static_cast<double>(n) / static_cast<double>(total);
+        entropy -= p * std::log2(p);
+    }
+    return 1.0 - entropy / 8.0;
+}
+
+size_t stored_length(QPDFObjectHandle &stream)
+{
+    auto length = stream.getDict().getKey("/Length");
+    if (length.isInteger() && length.getIntValue() > 0)
+        return static_cast<size_t>(length.getIntValue());
+    return 0;
+}
+
+struct PreparedStream {
+    QPDFObjectHandle stream;
+    std::unique_ptr<std::string> data;
+    bool compress;
+};
+
+// Gives QPDFWriter a stream's precompressed data, in place of its own. The data is
+// released once it has been written as many times as the writer will ask for it.
+class PrecompressedData : public QPDFObjectHandle::StreamDataProvider {
+public:
+    PrecompressedData(std::unique_ptr<std::string> data, int uses)
+        : data(std::move(data)), uses(uses)
+    {
+    }
+    virtual ~PrecompressedData() = default;
+
+    void provideStreamData(QPDFObjGen const &, Pipeline *pipeline) override
+    {
+        if (!this->data)
+            throw std::logic_error("precompressed stream data was already written");
+        pipeline->write(reinterpret_cast<unsigned char const *>(this->data->data()),
+            this->data->size());
+        pipeline->finish();
+        if (--this->uses == 0)
+            this->data.reset();
+    }
+
+private:
+    std::unique_ptr<std::string> data;
+    int uses;
+};
+
+} // namespace
+
+StreamPrecompressor::StreamPrecompressor(QPDF &q,
+    unsigned int threads,
+    bool recompress_flate,
+    qpdf_stream_decode_level_e decode_level,
+    int passes,
+    std::optional<CompressionPolicy> policy,
+    int default_level,
+    std::shared_ptr<CancellationToken> token)
+{
+    auto candidates = reachable_streams(q);
+    std::erase_if(candidates,
+        [&](auto &item) { return !should_precompress(item.first, recompress_flate); });
+
+    // Use the same backend for the whole save, even if another is selected meanwhile.
+    // With zlib selected, call zlib directly if we can, so that each stream can have
+    // its own level without touching qpdf's process-wide level, which other threads
+    // may be using.
+    auto backend = get_flate_backend();
+    if (!backend)
+        backend = get_zlib_level_backend();
+
+    std::vector<PreparedStream> prepared;
+    try {
+        WorkerPool pool(threads);
+        for (auto &[stream, cls] : candidates) {
+            if (token)
+                token->check();
+
+            // Reading and decoding must happen on this thread, since QPDF is not
+            // thread-safe. If the data cannot be decoded, let the writer deal with
+            // the stream as it normally would. The raw data is kept to put back
+            // after the write.
+            auto data = std::make_unique<std::string>();
+            std::string raw;
+            try {
+                Pl_String decoded("precompress decode", nullptr, *data);
+                bool filtered = false;
+                if (!stream.pipeStreamData(
+                        &decoded, &filtered, 0, decode_level, true, true) ||
+                    !filtered)
+                    continue;
+                Pl_String raw_data("precompress raw", nullptr, raw);
+                if (!stream.pipeStreamData(
+                        &raw_data, nullptr, 0, qpdf_dl_none, true, false))
+                    continue;
+            } catch (std::exception &) {
+                continue;
+            }
+
+            // Without a backend that takes a level, only the process-wide level can
+            // be used
+            int level = -1;
+            bool compress = true;
+            if (policy) {
+                if (backend)
+                    level = choose_level(*policy, cls, stored_length(stream));
+                double gain = estimate_gain(*data, policy->sample_size);
+                compress = gain >= policy->min_gain;
+                this->decisions_.push_back(
+                    {stream.getObjGen(), cls, data->size(), gain, level, compress});
+            }
+            auto dict = stream.getDict();
+            this->originals.push_back({stream,
+                std::move(raw),
+                dict.getKey("/Filter"),
+                dict.getKey("/DecodeParms"),
+                dict.getKey("/Length")});
+            prepared.push_back({stream, std::move(data), compress});
+            if (!compress)
+                continue;
+
+            auto *result = prepared.back().data.get();
+            int effective_level = level < 0 ? default_level : level;
+            pool.submit([result, backend, effective_level]() {
+                std::string input;
+                input.swap(*result);
+                if (backend) {
+                    *result = backend->compress(input, effective_level);
+                    return;
+                }
+                Pl_String output("precompress output", nullptr, *result);
+                Pl_Flate deflate("precompress deflate", &output, Pl_Flate::a_deflate);
+                auto *bytes = reinterpret_cast<unsigned char const *>(input.data());
+                deflate.write(bytes, input.size());
+                deflate.finish();
+            });
+        }
+        pool.wait();
+    } catch (...) {
+        this->originals.clear();
+        throw;
+    }
+
+    std::sort(this->decisions_.begin(),
+        this->decisions_.end(),
+        [](auto const &a, auto const &b) { return a.og < b.og; });
+
+    try {
+        for (auto &[stream, data, compress] : prepared) {
+            stream.replaceStreamData(
+                std::make_shared<PrecompressedData>(std::move(data), passes),
+                compress ? QPDFObjectHandle::newName("/FlateDecode")
+                         : QPDFObjectHandle::newNull(),
+                QPDFObjectHandle::newNull());
+            stream.setFilterOnWrite(false);
+            ++this->replaced;
+            if (compress)
+                ++this->compressed;
+        }
+    } catch (...) {
+        this->restore();
+        throw;
+    }
+}
+
+StreamPrecompressor::~StreamPrecompressor()
+{
+    try {
+        this->restore();
+    } catch (std::exception &) {
+        // Destructors must not throw; at worst some streams stay compressed
+    }
+}
+
+void StreamPrecompressor::restore()
+{
+    for (; this->replaced > 0; --this->replaced) {
+        auto &original = this->originals[this->replaced - 1];
+        auto &stream = original.stream;
+        stream.replaceStreamData(original.raw, original.filter, original.decode_parms);
+        // replaceStreamData sets /Length to the size of the data, which is the same,
+        // but it may have been an indirect object
+        if (original.length.isNull())
+            stream.getDict().removeKey("/Length");
+        else
+            stream.getDict().replaceKey("/Length", original.length);
+        stream.setFilterOnWrite(true);
+    }
+    this->originals.clear();
+}
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <qpdf/Constants.h>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjGen.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+#include "cancellation.h"
+
+// What a stream is used for, as far as choosing how to compress it is concerned
+enum class stream_class_e { content, font, image, other };
+
+// Per-stream compression choices; see pikepdf.CompressionPolicy.
+// Levels are zlib levels 0-9, or -1 for the process-wide level.
+struct CompressionPolicy {
+    double min_gain = 0.05;
+    size_t sample_size = 16 * 1024;
+    int content_level = -1;
+    int font_level = 9;
+    int image_level = 1;
+    int other_level = -1;
+    size_t large_stream_size = 4 * 1024 * 1024;
+    int large_stream_level = 1;
+};
+
+struct CompressionDecision {
+    QPDFObjGen og;
+    stream_class_e stream_class;
+    size_t size;           // Decoded size
+    double estimated_gain; // Estimated fraction of size saved by compressing
+    int level;             // Level used, or -1 for the process-wide level
+    bool compressed;
+};
+
+// Compresses stream data on worker threads ahead of QPDFWriter::write(), for the
+// streams that the writer would otherwise compress one at a time on the saving
+// thread.
+//
+// For the duration of the write, each such stream's data is replaced by a provider
+// that gives the writer the compressed data, marked not to be filtered again on
+// write. No objects are added to the Pdf. The destructor puts back each stream's
+// original raw data, /Filter, /DecodeParms and /Length, so the Pdf has the same
+// content as before; the raw data of these streams is then held in memory rather
+// than read from the file again. Each compressed payload is released as soon as the
+// writer has made its last pass over it.
+//
+// With a CompressionPolicy, each stream is first sampled; streams that are not
+// expected to shrink enough are written uncompressed, and the rest are compressed
+// at a level chosen by their class and size. qpdf only has a process-wide flate
+// level, which is never changed here, so with zlib selected each stream is
+// compressed by calling zlib directly. If pikepdf was built without zlib, the
+// process-wide level is used for every stream instead.
+//
+// If a flate backend other than zlib is selected, it does the compression.
+//
+// Compression is a pure function of each stream's data, so the output does not
+// depend on the number of threads or the order in which they finish.
+//
+// If a CancellationToken is given, it is checked before each stream is read.
+//
+// Must be constructed after the writer is configured and immediately before
+// write(). passes is the number of times the writer writes each stream: 2 when
+// linearizing, otherwise 1. Neither construction nor destruction requires the GIL.
+class StreamPrecompressor {
+public:
+    StreamPrecompressor(QPDF &q,
+        unsigned int threads,
+        bool recompress_flate,
+        qpdf_stream_decode_level_e decode_level,
+        int passes,
+        std::optional<CompressionPolicy> policy = std::nullopt,
+        int default_level = -1,
+        std::shared_ptr<CancellationToken> token = nullptr);
+    ~StreamPrecompressor();
+    StreamPrecompressor(const StreamPrecompressor &) = delete;
+    StreamPrecompressor &operator=(const StreamPrecompressor &) = delete;
+    StreamPrecompressor(StreamPrecompressor &&) = delete;
+    StreamPrecompressor &operator=(StreamPrecompressor &&) = delete;
+
+    // Number of streams that were compressed ahead of time
+    size_t count() const { return this->compressed; }
+    // What the compression policy decided for each stream, if there was a policy
+    std::vector<CompressionDecision> const &decisions() const
+    {
+        return this->decisions_;
+    }
+
+private:
+    void restore();
+
+    struct Original {
+        QPDFObjectHandle stream;
+        std::string raw;
+        QPDFObjectHandle filter;
+        QPDFObjectHandle decode_parms;
+        QPDFObjectHandle length;
+    };
+
+    // Streams whose data may be replaced, in order; the first `replaced` of them are
+    std::vector<Original> originals;
+    size_t replaced = 0;
+    std::vector<CompressionDecision> decisions_;
+    size_t compressed = 0;
+};
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <algorithm>
+
+#include "progress.h"
+
+PikeProgressReporter::PikeProgressReporter(py::object callback,
+    py::object event_callback,
+    std::shared_ptr<CancellationToken> token,
+    std::string phase,
+    size_t objects_total,
+    std::function<size_t()> bytes_written)
+    : callback(callback), event_callback(event_callback), token(token),
+      phase(std::move(phase)), objects_total(objects_total),
+      bytes_written(std::move(bytes_written)), start(clock::now())
+{
+    if (!this->event_callback.is_none())
+        this->event_type =
+            py::module_::import("pikepdf.models.progress").attr("ProgressEvent");
+}
+
+PikeProgressReporter::~PikeProgressReporter()
+{
+    // May be destroyed by qpdf without the GIL
+    py::gil_scoped_acquire gil;
+    this->callback = py::object();
+    this->event_callback = py::object();
+    this->event_type = py::object();
+}
+
+void PikeProgressReporter::reportProgress(int percent)
+{
+    if (this->token)
+        this->token->check();
+    if (this->callback.is_none() && this->event_callback.is_none())
+        return;
+
+    size_t bytes = this->bytes_written ? this->bytes_written() : 0;
+    std::chrono::duration<double> elapsed = clock::now() - this->start;
+    // qpdf reports the percentage of objects written, including both passes of a
+    // linearized write, so this is an estimate
+    size_t objects = this->objects_total * std::clamp(percent, 0, 100) / 100;
+
+    py::gil_scoped_acquire acquire;
+    if (!this->callback.is_none())
+        this->callback(percent);
+    if (!this->event_callback.is_none())
+        this->event_callback(this->event_type(this->phase,
+            percent,
+            objects,
+            this->objects_total,
+            bytes,
+            elapsed.count()));
+}
+
+std::shared_ptr<CancellationToken> get_cancellation_token(py::object token)
+{
+    if (token.is_none())
+        return nullptr;
+    return token.cast<std::shared_ptr<CancellationToken>>();
+}
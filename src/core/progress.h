@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <qpdf/QPDFWriter.hh>
+
+#include "cancellation.h"
+#include "pikepdf.h"
+
+// Reports the progress of a write to Python, as a percentage, as a
+// pikepdf.ProgressEvent or both, and checks for cancellation each time. qpdf
+// reports progress once per percent, so this is also how often a write notices
+// that it has been cancelled, apart from any checks made by the output pipeline.
+//
+// Acquires the GIL only when there is a Python callback to call, so the caller may
+// release it.
+class PikeProgressReporter : public QPDFWriter::ProgressReporter {
+public:
+    PikeProgressReporter(py::object callback,
+        py::object event_callback = py::none(),
+        std::shared_ptr<CancellationToken> token = nullptr,
+        std::string phase = "write",
+        size_t objects_total = 0,
+        std::function<size_t()> bytes_written = nullptr);
+    virtual ~PikeProgressReporter();
+
+    void reportProgress(int percent) override;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    py::object callback;
+    py::object event_callback;
+    py::object event_type;
+    std::shared_ptr<CancellationToken> token;
+    std::string phase;
+    size_t objects_total;
+    std::function<size_t()> bytes_written;
+    clock::time_point start;
+};
+
+// The CancellationToken passed from Python, or nullptr for None
+std::shared_ptr<CancellationToken> get_cancellation_token(py::object token);
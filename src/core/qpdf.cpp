@@ -1,16 +1,31 @@
 // SPDX-FileCopyrightText: 2022 James R. Barlow
 // SPDX-License-Identifier: MPL-2.0
 
+#include <atomic>
 #include <cerrno>
 #include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 
+#if !defined(_WIN32)
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 #include "pikepdf.h"
 
 #include <qpdf/Buffer.hh>
 #include <qpdf/BufferInputSource.hh>
-#include <qpdf/Pl_Discard.hh>
+#include <qpdf/MD5.hh>
+#include <qpdf/Pl_Flate.hh>
+#include <qpdf/Pl_String.hh>
+#include <qpdf/QIntC.hh>
 #include <qpdf/QPDFAcroFormDocumentHelper.hh>
 #include <qpdf/QPDFEmbeddedFileDocumentHelper.hh>
 #include <qpdf/QPDFExc.hh>
@@ -20,19 +35,122 @@
 #include <qpdf/QPDFSystemError.hh>
 #include <qpdf/QPDFWriter.hh>
 #include <qpdf/QPDFXRefEntry.hh>
+#include <qpdf/QUtil.hh>
 
 #include <pybind11/buffer_info.h>
 #include <pybind11/iostream.h>
 #include <pybind11/stl.h>
 
+#include "buffer_inputsource-inl.h"
+#include "fd_inputsource-inl.h"
 #include "jbig2-inl.h"
+#include "jbig2dec.h"
 #include "mmap_inputsource-inl.h"
 #include "pipeline.h"
+#include "precompress.h"
+#include "progress.h"
 #include "qpdf_inputsource-inl.h"
 #include "qpdf_pagelist.h"
+#include "streamcache.h"
+#include "suffix_inputsource-inl.h"
+#include "threadpool.h"
 #include "utils.h"
 
-enum access_mode_e { access_default, access_stream, access_mmap, access_mmap_only };
+enum access_mode_e {
+    access_default,
+    access_stream,
+    access_mmap,
+    access_mmap_only,
+    access_pread,
+    access_buffer,
+};
+
+// Memory mapped input sources, keyed by QPDF::getUniqueId(), so that whole document
+// operations can pass access pattern hints to the kernel. The QPDF owns the input
+// source; we only hold weak references.
+static std::mutex mmap_sources_mutex;
+static std::map<unsigned long long, std::weak_ptr<MmapInputSource>> mmap_sources;
+
+void register_mmap_source(QPDF &q, std::shared_ptr<MmapInputSource> source)
+{
+    std::lock_guard<std::mutex> lock(mmap_sources_mutex);
+    std::erase_if(mmap_sources, [](const auto &item) { return item.second.expired(); });
+    mmap_sources[q.getUniqueId()] = source;
+}
+
+void advise_access(QPDF &q, access_advice_e advice)
+{
+    std::shared_ptr<MmapInputSource> source;
+    {
+        std::lock_guard<std::mutex> lock(mmap_sources_mutex);
+        auto it = mmap_sources.find(q.getUniqueId());
+        if (it == mmap_sources.end())
+            return;
+        source = it->second.lock();
+    }
+    if (source)
+        source->advise(advice);
+}
+
+// For the duration of a whole document pass, hint that the input will be read
+// sequentially, then return to random access.
+class SequentialAccessScope {
+public:
+    SequentialAccessScope(QPDF &q) : q(q)
+    {
+        advise_access(this->q, access_advice_e::sequential);
+    }
+    ~SequentialAccessScope() { advise_access(this->q, access_advice_e::random); }
+    SequentialAccessScope(const SequentialAccessScope &) = delete;
+    SequentialAccessScope &operator=(const SequentialAccessScope &) = delete;
+    SequentialAccessScope(SequentialAccessScope &&) = delete;
+    SequentialAccessScope &operator=(SequentialAccessScope &&) = delete;
+
+private:
+    QPDF &q;
+};
+
+// Pdfs being saved, keyed by QPDF::getUniqueId(), with the thread saving each. Saves
+// run without the GIL, so no other thread may use the Pdf until the save finishes.
+static std::mutex saving_mutex;
+static std::map<unsigned long long, std::thread::id> saving_pdfs;
+// Lets checks skip the lock when no Pdf is being saved, which is the usual case
+static std::atomic<size_t> saving_count{0};
+
+void check_pdf_available(QPDF *q)
+{
+    if (!q || saving_count.load(std::memory_order_relaxed) == 0)
+        return;
+    std::lock_guard<std::mutex> lock(saving_mutex);
+    auto found = saving_pdfs.find(q->getUniqueId());
+    if (found != saving_pdfs.end() && found->second != std::this_thread::get_id())
+        throw std::runtime_error(
+            "this Pdf is being saved by another thread; wait for the save to finish");
+}
+
+// For the duration of a save, mark the Pdf as being saved by this thread, so that
+// other threads cannot use it.
+class SavingScope {
+public:
+    SavingScope(QPDF &q) : id(q.getUniqueId())
+    {
+        std::lock_guard<std::mutex> lock(saving_mutex);
+        if (!saving_pdfs.emplace(this->id, std::this_thread::get_id()).second)
+            throw std::runtime_error("this Pdf is already being saved");
+        saving_count = saving_pdfs.size();
+    }
+    ~SavingScope()
+    {
+        std::lock_guard<std::mutex> lock(saving_mutex);
+        saving_pdfs.erase(this->id);
+        saving_count = saving_pdfs.size();
+    }
+    SavingScope(const SavingScope &) = delete;
+    SavingScope &operator=(const SavingScope &) = delete;
+
+private:
+    unsigned long long id;
+};
 
 void qpdf_basic_settings(QPDF &q) // LCOV_EXCL_LINE
 {
@@ -41,6 +159,19 @@ void qpdf_basic_settings(QPDF &q) // LCOV_EXCL_LINE
     q.setLogger(get_pikepdf_logger());
 }
 
+// Process the input source. If we were given a saved xref index, it is presented to
+// qpdf as though it were appended to the file, so that qpdf reads the index instead
+// of the file's own cross-reference sections.
+void process_input_source(QPDF &q,
+    std::shared_ptr<InputSource> input_source,
+    const std::string &password,
+    const std::string &xref_index)
+{
+    if (!xref_index.empty())
+        input_source = std::make_shared<SuffixInputSource>(input_source, xref_index);
+    q.processInputSource(input_source, password.c_str());
+}
+
 // The holder for QPDF should still be shared_ptr because the Python Pdf.pages accessor
 // needs to keep a reference to the QPDF, since users can do things like:
 //  accessor = pdf.pages
@@ -53,9 +184,11 @@ std::shared_ptr<QPDF> open_pdf(py::object stream,
     bool suppress_warnings = true,
     bool attempt_recovery = true,
     bool inherit_page_attributes = true,
+    bool lazy_page_attributes = false,
     access_mode_e access_mode = access_mode_e::access_default,
     std::string description = "",
-    bool closing_stream = false)
+    bool closing_stream = false,
+    std::string xref_index = "")
 {
     auto q = std::make_shared<QPDF>();
 
@@ -69,14 +202,50 @@ std::shared_ptr<QPDF> open_pdf(py::object stream,
     if (access_mode == access_default)
         access_mode = get_mmap_default() ? access_mmap : access_stream;
 
+    if (access_mode == access_buffer) {
+        auto buffer_input_source =
+            std::make_unique<PythonBufferInputSource>(stream, description);
+        auto input_source = std::shared_ptr<InputSource>(buffer_input_source.release());
+        py::gil_scoped_release release;
+        process_input_source(*q, input_source, password, xref_index);
+        success = true;
+    }
+
+#if defined(_WIN32)
+    if (access_mode == access_pread)
+        access_mode = access_stream; // No pread() on Windows
+#else
+    if (access_mode == access_pread) {
+        // Only probing the stream for a usable file descriptor may fall back; errors
+        // from parsing the PDF must propagate
+        std::unique_ptr<FileDescriptorInputSource> fd_input_source;
+        try {
+            fd_input_source = std::make_unique<FileDescriptorInputSource>(
+                stream, description, closing_stream);
+        } catch (const py::error_already_set &) {
+            // Not a regular file or no fileno(); fallback to stream access
+            stream.attr("seek")(0);
+            access_mode = access_stream;
+        }
+        if (fd_input_source) {
+            auto input_source = std::shared_ptr<InputSource>(fd_input_source.release());
+            py::gil_scoped_release release;
+            process_input_source(*q, input_source, password, xref_index);
+            success = true;
+        }
+    }
+#endif
+
     if (access_mode == access_mmap || access_mode == access_mmap_only) {
         try {
             auto mmap_input_source =
-                std::make_unique<MmapInputSource>(stream, description, closing_stream);
-            auto input_source =
-                std::shared_ptr<InputSource>(mmap_input_source.release());
-            py::gil_scoped_release release;
-            q->processInputSource(input_source, password.c_str());
+                std::make_shared<MmapInputSource>(stream, description, closing_stream);
+            auto input_source = std::static_pointer_cast<InputSource>(mmap_input_source);
+            {
+                py::gil_scoped_release release;
+                process_input_source(*q, input_source, password, xref_index);
+            }
+            register_mmap_source(*q, mmap_input_source);
             success = true;
         } catch (const py::error_already_set &) {
             if (access_mode == access_mmap) {
@@ -94,7 +263,7 @@ std::shared_ptr<QPDF> open_pdf(py::object stream,
             stream, description, closing_stream);
         auto input_source = std::shared_ptr<InputSource>(stream_input_source.release());
         py::gil_scoped_release release;
-        q->processInputSource(input_source, password.c_str());
+        process_input_source(*q, input_source, password, xref_index);
         success = true;
     }
 
@@ -110,6 +279,8 @@ std::shared_ptr<QPDF> open_pdf(py::object stream,
         // so release the GIL again.
         py::gil_scoped_release release;
         q->pushInheritedAttributesToPage();
+    } else if (lazy_page_attributes) {
+        set_lazy_page_attributes(q);
     }
 
     if (!password.empty() && !q->isEncrypted()) {
@@ -120,21 +291,310 @@ std::shared_ptr<QPDF> open_pdf(py::object stream,
     return q;
 }
 
-class PikeProgressReporter : public QPDFWriter::ProgressReporter {
-public:
-    PikeProgressReporter(py::function callback) { this->callback = callback; }
+// One row of a cross-reference stream: type 1 rows are (offset, generation),
+// type 2 rows are (object stream number, index within the object stream)
+struct XRefRow {
+    int type;
+    unsigned long long field2;
+    unsigned long long field3;
+};
 
-    virtual ~PikeProgressReporter() = default;
+// Keys of an xref stream dictionary or trailer that describe the cross-reference
+// section itself, rather than the document
+static const std::set<std::string> xref_keys = {"/Type",
+    "/Size",
+    "/W",
+    "/Index",
+    "/Length",
+    "/Filter",
+    "/DecodeParms",
+    "/Prev",
+    "/XRefStm"};
 
-    virtual void reportProgress(int percent) override
-    {
-        py::gil_scoped_acquire acquire;
-        this->callback(percent);
+// Serialize a cross-reference stream numbered xref_objid, holding rows keyed by
+// object number, followed by the document keys of trailer. If prev is not negative,
+// the stream links to the previous cross-reference section at that offset.
+std::string unparse_xref_stream(int xref_objid,
+    std::map<int, XRefRow> const &rows,
+    QPDFObjectHandle trailer,
+    qpdf_offset_t prev = -1)
+{
+    auto bytes_needed = [](unsigned long long value) {
+        int n = 1;
+        while (value >>= 8)
+            ++n;
+        return n;
+    };
+    unsigned long long max_field2 = 0, max_field3 = 0;
+    for (auto const &[objid, row] : rows) {
+        max_field2 = std::max(max_field2, row.field2);
+        max_field3 = std::max(max_field3, row.field3);
     }
+    int w2 = bytes_needed(max_field2);
+    int w3 = bytes_needed(max_field3);
 
-private:
-    py::function callback;
-};
+    auto put = [](std::string &data, unsigned long long value, int width) {
+        for (int i = width - 1; i >= 0; --i)
+            data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    };
+    std::string data;
+    std::ostringstream index;
+    int range_start = -1, range_count = 0;
+    for (auto const &[objid, row] : rows) {
+        data.push_back(static_cast<char>(row.type));
+        put(data, row.field2, w2);
+        put(data, row.field3, w3);
+        if (range_start >= 0 && objid == range_start + range_count) {
+            ++range_count;
+        } else {
+            if (range_start >= 0)
+                index << range_start << " " << range_count << " ";
+            range_start = objid;
+            range_count = 1;
+        }
+    }
+    index << range_start << " " << range_count;
+
+    std::ostringstream out;
+    out << xref_objid << " 0 obj\n<< /Type /XRef /Size " << xref_objid + 1
+        << " /W [ 1 " << w2 << " " << w3 << " ] /Index [ " << index.str()
+        << " ] /Length " << data.size();
+    if (prev >= 0)
+        out << " /Prev " << prev;
+    for (auto const &key : trailer.getKeys()) {
+        if (xref_keys.count(key))
+            continue;
+        out << " " << QPDFObjectHandle::newName(key).unparse() << " "
+            << trailer.getKey(key).unparse();
+    }
+    out << " >>\nstream\n" << data << "\nendstream\nendobj\n";
+    return out.str();
+}
+
+// Serialize the resolved cross-reference table and the trailer as a single
+// cross-reference stream, with startxref and %%EOF, for use as a saved xref index.
+// offset is where the index will appear to begin when it is appended to the file,
+// relative to the PDF header, since that is how qpdf measures offsets.
+py::bytes make_xref_index(QPDF &q, qpdf_offset_t offset)
+{
+    // Keep one entry per object number, preferring the highest generation
+    std::map<int, std::pair<int, QPDFXRefEntry>> entries;
+    for (auto const &[og, entry] : q.getXRefTable()) {
+        if (entry.getType() != 1 && entry.getType() != 2)
+            continue;
+        auto it = entries.find(og.getObj());
+        if (it == entries.end() || it->second.first < og.getGen())
+            entries[og.getObj()] = {og.getGen(), entry};
+    }
+
+    if (entries.empty())
+        throw py::value_error("PDF was not read from a file, so it cannot be indexed");
+
+    auto trailer = q.getTrailer();
+    int xref_objid = entries.rbegin()->first + 1;
+    if (trailer.hasKey("/Size") && trailer.getKey("/Size").isInteger())
+        xref_objid = std::max(xref_objid, trailer.getKey("/Size").getIntValueAsInt());
+
+    std::map<int, XRefRow> rows;
+    for (auto const &[objid, item] : entries) {
+        auto const &[gen, entry] = item;
+        if (entry.getType() == 2) {
+            rows[objid] = {2,
+                static_cast<unsigned long long>(entry.getObjStreamNumber()),
+                static_cast<unsigned long long>(entry.getObjStreamIndex())};
+        } else {
+            rows[objid] = {1,
+                static_cast<unsigned long long>(entry.getOffset()),
+                static_cast<unsigned long long>(gen)};
+        }
+    }
+
+    // The index starts with a newline, in case the file does not end with one. The
+    // xref stream is deliberately left out of its own table, so that it does not
+    // show up as an object of the PDF.
+    auto xref_offset = offset + 1;
+
+    std::ostringstream out;
+    out << "\n"
+        << unparse_xref_stream(xref_objid, rows, trailer) << "startxref\n"
+        << xref_offset << "\n%%EOF\n";
+    return py::bytes(out.str());
+}
+
+// Is current, an object of q, the same as base, the object with the same number in
+// the original file? Objects are compared by their PDF syntax. Stream data is only
+// compared by where it was read from, since reading it could be expensive.
+bool same_as_original(QPDFObjectHandle current,
+    QPDFObjectHandle base,
+    QPDFXRefEntry const *current_entry,
+    QPDFXRefEntry const &base_entry)
+{
+    if (current.getTypeCode() != base.getTypeCode())
+        return false;
+    if (!current.isStream())
+        return current.unparseResolved() == base.unparseResolved();
+
+    if (current.isDataModified() || !current_entry ||
+        current_entry->getType() != base_entry.getType())
+        return false;
+    if (base_entry.getType() == 1) {
+        if (current_entry->getOffset() != base_entry.getOffset())
+            return false;
+    } else if (current_entry->getObjStreamNumber() != base_entry.getObjStreamNumber() ||
+               current_entry->getObjStreamIndex() != base_entry.getObjStreamIndex()) {
+        return false;
+    }
+    return current.getDict().unparse() == base.getDict().unparse();
+}
+
+// Serialize q as an incremental update to original: the objects that differ from
+// original, a cross-reference section for them, and a trailer that links to
+// original's last cross-reference section at prev. The update is meant to be
+// appended to the bytes original was opened from, at offset (relative to the PDF
+// header, as with make_xref_index). Returns the update and the number of objects in
+// it.
+py::tuple make_incremental_update(QPDF &q,
+    QPDF &original,
+    qpdf_offset_t offset,
+    qpdf_offset_t prev,
+    bool xref_stream,
+    bool compress_streams)
+{
+    if (q.isEncrypted() || original.isEncrypted())
+        throw py::value_error("incremental updates of encrypted PDFs are not supported");
+
+    auto const &base_xref = original.getXRefTable();
+    auto const &own_xref = q.getXRefTable();
+
+    // Changed objects, keeping the highest generation of each object number
+    std::map<int, QPDFObjectHandle> changed;
+    for (auto &oh : q.getAllObjects()) {
+        auto og = oh.getObjGen();
+        auto base_it = base_xref.find(og);
+        bool in_base = base_it != base_xref.end() &&
+                       (base_it->second.getType() == 1 || base_it->second.getType() == 2);
+        // A reference to a missing object is null anyway, and objects of the
+        // original that are now null have been deleted; see below
+        if (oh.isNull())
+            continue;
+        if (in_base) {
+            auto own_it = own_xref.find(og);
+            auto const *own_entry = own_it != own_xref.end() ? &own_it->second : nullptr;
+            if (same_as_original(
+                    oh, original.getObject(og), own_entry, base_it->second))
+                continue;
+        }
+        auto it = changed.find(og.getObj());
+        if (it == changed.end() || it->second.getGeneration() < og.getGen())
+            changed[og.getObj()] = oh;
+    }
+
+    // The update starts with a newline, in case the file does not end with one
+    std::string out = "\n";
+    std::map<int, XRefRow> rows;
+    // Objects of the original that have been replaced with null, which is how
+    // objects are deleted, get free entries with the generation a reused object
+    // number would have. The entries are not linked into a free list, which is
+    // only a hint for reusing numbers.
+    for (auto const &[og, entry] : base_xref) {
+        bool in_use = entry.getType() == 1 || entry.getType() == 2;
+        if (!in_use || changed.count(og.getObj()))
+            continue;
+        if (q.getObject(og).isNull() && !original.getObject(og).isNull()) {
+            auto gen = std::min(og.getGen() + 1, 65535);
+            rows[og.getObj()] = {0, 0, static_cast<unsigned long long>(gen)};
+        }
+    }
+    for (auto &[objid, oh] : changed) {
+        rows[objid] = {1,
+            static_cast<unsigned long long>(offset + QIntC::to_offset(out.size())),
+            static_cast<unsigned long long>(oh.getGeneration())};
+        out += std::to_string(objid) + " " + std::to_string(oh.getGeneration()) +
+               " obj\n";
+        if (!oh.isStream()) {
+            out += oh.unparseResolved();
+            out += "\nendobj\n";
+            continue;
+        }
+
+        std::string data;
+        Pl_String raw("incremental raw", nullptr, data);
+        oh.pipeStreamData(&raw, 0, qpdf_dl_none);
+        auto dict = oh.getDict().shallowCopy();
+        if (compress_streams && !dict.hasKey("/Filter") &&
+            !dict.getKey("/Type").isNameAndEquals("/Metadata")) {
+            std::string compressed;
+            Pl_String output("incremental output", nullptr, compressed);
+            Pl_Flate deflate("incremental deflate", &output, Pl_Flate::a_deflate);
+            deflate.write(reinterpret_cast<unsigned char const *>(data.data()),
+                data.size());
+            deflate.finish();
+            data = std::move(compressed);
+            dict.replaceKey("/Filter", QPDFObjectHandle::newName("/FlateDecode"));
+            dict.removeKey("/DecodeParms");
+        }
+        dict.replaceKey(
+            "/Length", QPDFObjectHandle::newInteger(QIntC::to_longlong(data.size())));
+        out += dict.unparse();
+        out += "\nstream\n";
+        out += data;
+        out += "\nendstream\nendobj\n";
+    }
+
+    // Build the new trailer from the document keys of q's trailer
+    auto trailer = QPDFObjectHandle::newDictionary();
+    auto own_trailer = q.getTrailer();
+    for (auto const &key : own_trailer.getKeys()) {
+        if (!xref_keys.count(key) && key != "/Encrypt")
+            trailer.replaceKey(key, own_trailer.getKey(key));
+    }
+    // Keep the permanent identifier and change the one that identifies this version
+    auto id = trailer.getKey("/ID");
+    if (id.isArray() && id.getArrayNItems() == 2) {
+        MD5 md5;
+        md5.encodeDataIncrementally(out.data(), out.size());
+        md5.encodeString(std::to_string(prev).c_str());
+        trailer.replaceKey("/ID",
+            QPDFObjectHandle::newArray({id.getArrayItem(0),
+                QPDFObjectHandle::newString(QUtil::hex_decode(md5.unparse()))}));
+    }
+
+    int size = changed.empty() ? 0 : changed.rbegin()->first + 1;
+    auto base_size = original.getTrailer().getKey("/Size");
+    if (base_size.isInteger())
+        size = std::max(size, base_size.getIntValueAsInt());
+
+    auto xref_offset = offset + QIntC::to_offset(out.size());
+    if (xref_stream) {
+        // Original uses cross-reference streams, so the update must too
+        rows[size] = {1, static_cast<unsigned long long>(xref_offset), 0};
+        out += unparse_xref_stream(size, rows, trailer, prev);
+    } else {
+        trailer.replaceKey("/Size", QPDFObjectHandle::newInteger(size));
+        trailer.replaceKey("/Prev", QPDFObjectHandle::newInteger(prev));
+        std::ostringstream table;
+        table << "xref\n";
+        for (auto it = rows.begin(); it != rows.end();) {
+            auto run_end = it;
+            int count = 0;
+            while (run_end != rows.end() && run_end->first == it->first + count) {
+                ++run_end;
+                ++count;
+            }
+            table << it->first << " " << count << "\n";
+            for (; it != run_end; ++it) {
+                table << std::setw(10) << std::setfill('0') << it->second.field2 << " "
+                      << std::setw(5) << std::setfill('0') << it->second.field3
+                      << (it->second.type == 0 ? " f \n" : " n \n");
+            }
+        }
+        table << "trailer\n" << trailer.unparse() << "\n";
+        out += table.str();
+    }
+    out += "startxref\n" + std::to_string(xref_offset) + "\n%%EOF\n";
+
+    return py::make_tuple(py::bytes(out), changed.size());
+}
 
 void update_xmp_pdfversion(QPDF &q, std::string version)
 {
@@ -323,7 +783,69 @@ pdf_version_extension get_version_extension(py::object ver_ext)
     return pdf_version_extension(version, extension);
 }
 
-void save_pdf(QPDF &q,
+#if !defined(_WIN32)
+// If a Python stream is a plain file object backed by a regular file, prepare to
+// write to its file descriptor directly: flush the stream's buffers and move the
+// descriptor to the stream's position, which is returned in start. Returns -1 if
+// the stream cannot be written directly.
+//
+// Only the exact io types qualify. Wrappers such as gzip.GzipFile report the
+// fileno() of the file they wrap, but transform what is written to them, and so
+// may subclasses.
+int get_direct_output_fd(py::object stream, qpdf_offset_t &start)
+{
+    auto io = py::module_::import("io");
+    auto type = py::type::of(stream);
+    if (!type.is(io.attr("FileIO")) && !type.is(io.attr("BufferedWriter")) &&
+        !type.is(io.attr("BufferedRandom")))
+        return -1;
+
+    int fd = -1;
+    try {
+        fd = stream.attr("fileno")().cast<int>();
+    } catch (const py::error_already_set &) {
+        return -1; // No fileno(), or io.UnsupportedOperation
+    } catch (const py::cast_error &) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return -1;
+
+    stream.attr("flush")();
+    auto pos = stream.attr("tell")().cast<qpdf_offset_t>();
+    if (::lseek(fd, static_cast<off_t>(pos), SEEK_SET) < 0)
+        return -1;
+    start = pos;
+    return fd;
+}
+#endif
+
+CompressionPolicy get_compression_policy(py::object policy_obj)
+{
+    py::dict fields = policy_obj.attr("_asdict")();
+    CompressionPolicy policy;
+    policy.min_gain = fields["min_gain"].cast<double>();
+    policy.sample_size = fields["sample_size"].cast<size_t>();
+    policy.content_level = fields["content_level"].cast<int>();
+    policy.font_level = fields["font_level"].cast<int>();
+    policy.image_level = fields["image_level"].cast<int>();
+    policy.other_level = fields["other_level"].cast<int>();
+    policy.large_stream_size = fields["large_stream_size"].cast<size_t>();
+    policy.large_stream_level = fields["large_stream_level"].cast<int>();
+    for (int level : {policy.content_level,
+             policy.font_level,
+             policy.image_level,
+             policy.other_level,
+             policy.large_stream_level}) {
+        if (level < -1 || level > 9)
+            throw py::value_error(
+                "Flate compression level must be between 0 and 9 (or -1)");
+    }
+    return policy;
+}
+
+py::dict save_pdf(std::shared_ptr<QPDF> pdf,
     py::object stream,
     bool static_id = false,
     bool preserve_pdfa = true,
@@ -340,9 +862,16 @@ void save_pdf(QPDF &q,
     py::object encryption = py::none(),
     bool samefile_check = true,
     bool recompress_flate = false,
-    bool deterministic_id = false)
+    bool deterministic_id = false,
+    py::object compress_threads = py::none(),
+    py::object compression_policy = py::none(),
+    py::object progress_event = py::none(),
+    py::object cancellation_token = py::none())
 {
+    QPDF &q = *pdf;
+    SavingScope saving(q);
     QPDFWriter w(q);
+    auto token = get_cancellation_token(cancellation_token);
 
     if (static_id) {
         w.setStaticID(true);
@@ -367,9 +896,29 @@ void save_pdf(QPDF &q,
 
     std::string description = py::repr(stream);
 
-    // We must set up the output pipeline before we configure encryption
-    Pl_PythonOutput output_pipe(description.c_str(), stream);
-    w.setOutputPipeline(&output_pipe);
+    // We must set up the output pipeline before we configure encryption.
+    // If the stream is a regular file, we write to its file descriptor directly, so
+    // the write never needs the GIL. Otherwise we write through the Python stream,
+    // or for Pdf.iter_save, hand chunks to the consuming thread.
+    std::unique_ptr<Pl_BufferedOutput> output_pipe;
+    qpdf_offset_t direct_start = -1;
+    bool to_queue = py::isinstance<OutputChunkQueue>(stream);
+    if (to_queue) {
+        output_pipe = std::make_unique<Pl_ChunkQueueOutput>(description.c_str(),
+            stream.cast<std::shared_ptr<OutputChunkQueue>>());
+    }
+#if !defined(_WIN32)
+    if (!output_pipe) {
+        int fd = get_direct_output_fd(stream, direct_start);
+        if (fd >= 0)
+            output_pipe =
+                std::make_unique<Pl_FileDescriptorOutput>(description.c_str(), fd);
+    }
+#endif
+    if (!output_pipe)
+        output_pipe = std::make_unique<Pl_PythonOutput>(description.c_str(), stream);
+    output_pipe->set_cancellation_token(token);
+    w.setOutputPipeline(output_pipe.get());
 
     // Possibilities:
     // encryption=True -> preserve existing
@@ -415,19 +964,130 @@ void save_pdf(QPDF &q,
         update_xmp_pdfversion(q, w.getFinalVersion());
     }
 
-    if (!progress.is_none()) {
-        std::shared_ptr<QPDFWriter::ProgressReporter> reporter =
-            std::make_shared<PikeProgressReporter>(progress);
-        w.registerProgressReporter(reporter);
+    if (!progress.is_none() || !progress_event.is_none() || token) {
+        auto *pipe = output_pipe.get();
+        w.registerProgressReporter(std::make_shared<PikeProgressReporter>(progress,
+            progress_event,
+            token,
+            "write",
+            q.getObjectCount(),
+            [pipe]() { return pipe->stats().bytes; }));
+    }
+
+    // Compress streams on worker threads ahead of the write, only in the
+    // cases where the writer would compress them with the default settings.
+    // QDF mode and content normalization rewrite stream data themselves.
+    std::optional<CompressionPolicy> policy;
+    if (!compression_policy.is_none())
+        policy = get_compression_policy(compression_policy);
+    bool parallel = !compress_threads.is_none();
+    unsigned int threads =
+        parallel ? WorkerPool::thread_count(compress_threads.cast<int>()) : 1;
+    bool precompress = (parallel || policy) &&
+                       compress_streams && !qdf && !normalize_content;
+    int flate_level = get_flate_compression_level();
+    std::vector<CompressionDecision> decisions;
+    auto decode_level = stream_decode_level.is_none()
+                            ? qpdf_dl_generalized
+                            : stream_decode_level.cast<qpdf_stream_decode_level_e>();
+    size_t precompressed_streams = 0;
+
+    {
+        // When writing directly to a file descriptor, or to the queue of
+        // Pdf.iter_save, nothing in the output path needs Python, and everything
+        // else that calls back into Python during the write (reading a Python input
+        // stream, progress reporting, token filters, decoders) acquires the GIL
+        // itself, so other Python threads can run while we write. The SavingScope
+        // stops them from using the Pdf meanwhile. Output to a Python stream keeps
+        // the GIL.
+        SequentialAccessScope sequential(q);
+        std::optional<py::gil_scoped_release> release;
+        if (direct_start >= 0 || to_queue)
+            release.emplace();
+        LazyPageAttributesScope lazy_pages(q);
+        if (precompress) {
+            StreamPrecompressor precompressor(q,
+                threads,
+                recompress_flate,
+                decode_level,
+                linearize ? 2 : 1,
+                policy,
+                flate_level,
+                token);
+            precompressed_streams = precompressor.count();
+            decisions = precompressor.decisions();
+            w.write();
+        } else {
+            w.write();
+        }
     }
 
-    w.write();
+    auto const &stats = output_pipe->stats();
+    if (direct_start >= 0) {
+        // Tell the Python stream where we left the file descriptor
+        stream.attr("seek")(direct_start + QIntC::to_offset(stats.bytes));
+    }
+    py::dict result;
+    result["bytes_written"] = stats.bytes;
+    result["chunks"] = stats.chunks;
+    result["stream_writes"] = stats.stream_writes;
+    result["direct"] = direct_start >= 0;
+    result["precompressed_streams"] = precompressed_streams;
+    if (policy && precompress) {
+        static const char *class_names[] = {"content", "font", "image", "other"};
+        py::list decision_list;
+        for (auto const &d : decisions) {
+            py::dict decision;
+            decision["objgen"] = py::make_tuple(d.og.getObj(), d.og.getGen());
+            decision["class"] = class_names[static_cast<int>(d.stream_class)];
+            decision["size"] = d.size;
+            decision["estimated_gain"] = d.estimated_gain;
+            decision["level"] = d.level;
+            decision["compressed"] = d.compressed;
+            decision_list.append(decision);
+        }
+        result["compression_decisions"] = decision_list;
+    }
+    return result;
+}
+
+// Drop anything cached for an object whose value has been replaced
+void forget_replaced_object(QPDF &q, QPDFObjGen og)
+{
+    auto oh = q.getObject(og);
+    jbig2_globals_forget(oh);
+    forget_decoded_stream(q, og);
 }
 
 void init_qpdf(py::module_ &m)
 {
     QPDF::registerStreamFilter("/JBIG2Decode", &JBIG2StreamFilter::factory);
 
+    py::class_<CancellationToken, std::shared_ptr<CancellationToken>>(
+        m, "CancellationToken")
+        .def(py::init<std::optional<double>>(), py::arg("timeout") = py::none())
+        .def("cancel", &CancellationToken::cancel)
+        .def_property_readonly("cancelled", &CancellationToken::cancelled)
+        .def_property_readonly("remaining", &CancellationToken::remaining)
+        .def("check", &CancellationToken::check);
+
+    py::class_<OutputChunkQueue, std::shared_ptr<OutputChunkQueue>>(
+        m, "_OutputChunkQueue")
+        .def(py::init<size_t, size_t>(), py::arg("chunk_size"), py::arg("max_chunks"))
+        .def("get",
+            [](OutputChunkQueue &queue) -> py::object {
+                std::optional<std::string> chunk;
+                {
+                    py::gil_scoped_release release;
+                    chunk = queue.get();
+                }
+                if (!chunk)
+                    return py::none();
+                return py::bytes(*chunk);
+            })
+        .def("close", &OutputChunkQueue::close)
+        .def("cancel", &OutputChunkQueue::cancel);
+
     py::enum_<qpdf_object_stream_e>(m, "ObjectStreamMode")
         .value("disable", qpdf_object_stream_e::qpdf_o_disable)
         .value("preserve", qpdf_object_stream_e::qpdf_o_preserve)
@@ -450,7 +1110,9 @@ void init_qpdf(py::module_ &m)
         .value("default", access_mode_e::access_default)
         .value("stream", access_mode_e::access_stream)
         .value("mmap", access_mode_e::access_mmap)
-        .value("mmap_only", access_mode_e::access_mmap_only);
+        .value("mmap_only", access_mode_e::access_mmap_only)
+        .value("pread", access_mode_e::access_pread)
+        .value("buffer", access_mode_e::access_buffer);
 
     py::class_<QPDF, py::smart_holder>(
         m, "Pdf", "In-memory representation of a PDF", py::dynamic_attr())
@@ -471,9 +1133,11 @@ void init_qpdf(py::module_ &m)
             py::arg("suppress_warnings") = true,
             py::arg("attempt_recovery") = true,
             py::arg("inherit_page_attributes") = true,
+            py::arg("lazy_page_attributes") = false,
             py::arg("access_mode") = access_mode_e::access_default,
             py::arg("description") = "",
-            py::arg("closing_stream") = false)
+            py::arg("closing_stream") = false,
+            py::arg("xref_index") = "")
         .def("__repr__",
             [](QPDF &q) {
                 return std::string("<pikepdf.Pdf description='") + q.getFilename() +
@@ -525,6 +1189,7 @@ void init_qpdf(py::module_ &m)
                 QPDFPageDocumentHelper helper(q);
                 helper.removeUnreferencedResources();
             })
+        .def("deduplicate_streams", deduplicate_streams)
         .def("_save",
             save_pdf,
             py::arg("stream"),
@@ -544,7 +1209,11 @@ void init_qpdf(py::module_ &m)
             py::arg("encryption") = py::none(),
             py::arg("samefile_check") = true,
             py::arg("recompress_flate") = false,
-            py::arg("deterministic_id") = false)
+            py::arg("deterministic_id") = false,
+            py::arg("compress_threads") = py::none(),
+            py::arg("compression_policy") = py::none(),
+            py::arg("progress_event") = py::none(),
+            py::arg("cancellation_token") = py::none())
         .def("_get_object_id", &QPDF::getObjectByID)
         .def(
             "get_object",
@@ -580,33 +1249,107 @@ void init_qpdf(py::module_ &m)
                                         "pages from one PDF to another.");
             })
         .def("_replace_object",
-            [](QPDF &q, std::pair<int, int> objgen, QPDFObjectHandle &h) {
+            [](QPDF &q, std::pair<int, int> objgen, py::object obj) {
+                // None replaces the object with null, deleting it
+                auto h = objecthandle_encode(obj);
                 q.replaceObject(objgen.first, objgen.second, h);
+                forget_replaced_object(q, QPDFObjGen(objgen.first, objgen.second));
             })
         .def("_swap_objects",
             [](QPDF &q, std::pair<int, int> objgen1, std::pair<int, int> objgen2) {
                 QPDFObjGen o1(objgen1.first, objgen1.second);
                 QPDFObjGen o2(objgen2.first, objgen2.second);
                 q.swapObjects(o1, o2);
+                forget_replaced_object(q, o1);
+                forget_replaced_object(q, o2);
             })
         .def(
             "_close",
-            [](QPDF &q) { q.closeInputSource(); },
+            [](QPDF &q) {
+                q.closeInputSource();
+                if (auto cache = get_decoded_stream_cache(q))
+                    cache->clear();
+            },
             "Used to implement Pdf.close().")
-        .def("_decode_all_streams_and_discard",
-            [](QPDF &q, py::object progress = py::none()) {
+        .def("_xref_index",
+            &make_xref_index,
+            py::arg("offset"),
+            "Return a saved cross-reference index for this PDF; see pikepdf.xref_index.")
+        .def("_incremental_update",
+            &make_incremental_update,
+            py::arg("original"),
+            py::arg("offset"),
+            py::arg("prev"),
+            py::arg("xref_stream"),
+            py::arg("compress_streams"),
+            "Return an incremental update to original; see pikepdf._incremental.")
+        .def("validate_streams",
+            validate_streams,
+            py::kw_only(),
+            py::arg("threads") = 0,
+            py::arg("cancellation_token") = py::none())
+        .def(
+            "enable_decoded_stream_cache",
+            [](py::object pdf, size_t max_bytes) {
+                if (max_bytes == 0)
+                    throw py::value_error("max_bytes must be at least 1");
+                set_decoded_stream_cache(pdf.cast<std::shared_ptr<QPDF>>(), max_bytes);
+            },
+            py::arg("max_bytes") = 64 * 1024 * 1024)
+        .def("disable_decoded_stream_cache",
+            [](py::object pdf) {
+                set_decoded_stream_cache(pdf.cast<std::shared_ptr<QPDF>>(), 0);
+            })
+        .def_property_readonly("decoded_stream_cache_stats",
+            [](QPDF &q) -> py::object {
+                auto cache = get_decoded_stream_cache(q);
+                if (!cache)
+                    return py::none();
+                auto stats = cache->stats();
+                py::dict result;
+                result["hits"] = stats.hits;
+                result["misses"] = stats.misses;
+                result["entries"] = stats.entries;
+                result["bytes"] = stats.bytes;
+                result["max_bytes"] = stats.max_bytes;
+                return result;
+            })
+        .def("read_streams",
+            read_streams,
+            py::arg("objects"),
+            py::kw_only(),
+            py::arg("decode_level") = qpdf_dl_generalized,
+            py::arg("threads") = 0)
+        .def("_collect_images",
+            collect_images,
+            "List each image XObject used by the pages, with its name and pages.")
+        .def(
+            "_decode_all_streams_and_discard",
+            [](QPDF &q,
+                py::object progress,
+                py::object progress_event,
+                py::object cancellation_token) {
+                auto token = get_cancellation_token(cancellation_token);
                 QPDFWriter w(q);
-                Pl_Discard discard;
+                Pl_DiscardOutput discard("decode all streams", token);
                 w.setOutputPipeline(&discard);
                 w.setDecodeLevel(qpdf_dl_all);
                 w.setLinearization(false);
                 w.setCompressStreams(false);
                 w.setRecompressFlate(false);
-                if (!progress.is_none()) {
+                if (!progress.is_none() || !progress_event.is_none() || token) {
                     w.registerProgressReporter(
-                        std::make_shared<PikeProgressReporter>(progress));
+                        std::make_shared<PikeProgressReporter>(progress,
+                            progress_event,
+                            token,
+                            "decode",
+                            q.getObjectCount(),
+                            [&discard]() { return discard.bytes(); }));
                 }
+                SequentialAccessScope sequential(q);
                 try {
+                    // Decoders that call into Python acquire the GIL themselves
+                    py::gil_scoped_release release;
                     w.write();
                 } catch (py::error_already_set &e) {
                     auto cls_dependency_error =
@@ -618,12 +1361,16 @@ void init_qpdf(py::module_ &m)
                             "(probably jbig2dec) so not all stream contents can be "
                             "tested.");
                         w.setDecodeLevel(qpdf_dl_generalized);
+                        py::gil_scoped_release release;
                         w.write();
                     } else {
                         throw;
                     }
                 }
-            })
+            },
+            py::arg("progress") = py::none(),
+            py::arg("progress_event") = py::none(),
+            py::arg("cancellation_token") = py::none())
         .def_property_readonly(
             "_allow_accessibility", [](QPDF &q) { return q.allowAccessibility(); })
         .def_property_readonly(
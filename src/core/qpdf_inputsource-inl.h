@@ -1,12 +1,17 @@
 // SPDX-FileCopyrightText: 2022 James R. Barlow
 // SPDX-License-Identifier: MPL-2.0
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 #include <qpdf/Constants.h>
 #include <qpdf/DLL.h>
 #include <qpdf/InputSource.hh>
+#include <qpdf/QIntC.hh>
 #include <qpdf/QPDF.hh>
 #include <qpdf/QPDFExc.hh>
 #include <qpdf/QUtil.hh>
@@ -15,6 +20,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "inputsource_eol.h"
 #include "pikepdf.h"
 #include "utils.h"
 
@@ -23,16 +29,19 @@
 // since Python objects may be created/destroyed in the process of calling the
 // constructor.
 // When opening the PDF, we release the GIL before calling processInputSource
-// and similar, so we have to acquire it before calling back into Python, which we do
-// (oof) on every read or seek. The benefit is it allows us to use native Python
-// streams. Previous versions had a special code path for C based I/O.
+// and similar, so we have to acquire it before calling back into Python. To keep
+// that rare, we track the file position ourselves and keep a small LRU cache of
+// fixed size blocks read from the stream, so that only cache misses call into
+// Python. qpdf's tokenizer issues many tiny reads, most of which are served from
+// the cache. The stream must not be modified while the PDF is open.
 // When Python is manipulating the PDF, generally the GIL is held, but we
 // can release before doing a read, provided the other thread does not mess with
 // our file.
 class PythonStreamInputSource : public InputSource {
 public:
     PythonStreamInputSource(const py::object &stream, std::string name, bool close)
-        : name(name), close(close)
+        : name(name), close(close), block_size(get_stream_cache_block_size()),
+          max_blocks(get_stream_cache_blocks())
     {
         py::gil_scoped_acquire gil; // GIL must be held anyway, issue #295
         this->stream = stream;
@@ -40,6 +49,9 @@ public:
             throw py::value_error("not readable");
         if (!this->stream.attr("seekable")().cast<bool>())
             throw py::value_error("not seekable");
+        this->stream.attr("seek")(0, SEEK_END);
+        this->size = py::cast<qpdf_offset_t>(this->stream.attr("tell")());
+        this->stream.attr("seek")(0, SEEK_SET);
     }
     virtual ~PythonStreamInputSource()
     {
@@ -61,16 +73,31 @@ public:
 
     std::string const &getName() const override { return this->name; }
 
-    qpdf_offset_t tell() override
-    {
-        py::gil_scoped_acquire gil;
-        return py::cast<qpdf_offset_t>(this->stream.attr("tell")());
-    }
+    qpdf_offset_t tell() override { return this->cur_offset; }
 
     void seek(qpdf_offset_t offset, int whence) override
     {
-        py::gil_scoped_acquire gil;
-        this->stream.attr("seek")(offset, whence);
+        switch (whence) {
+        case SEEK_SET:
+            this->cur_offset = offset;
+            break;
+        case SEEK_END:
+            QIntC::range_check(this->size, offset);
+            this->cur_offset = this->size + offset;
+            break;
+        case SEEK_CUR:
+            QIntC::range_check(this->cur_offset, offset);
+            this->cur_offset += offset;
+            break;
+        default:
+            // LCOV_EXCL_START
+            throw std::logic_error(
+                "INTERNAL ERROR: invalid argument to PythonStreamInputSource::seek");
+            // LCOV_EXCL_STOP
+        }
+        if (this->cur_offset < 0) {
+            throw std::runtime_error(this->name + ": seek before beginning of stream");
+        }
     }
 
     // LCOV_EXCL_START
@@ -83,79 +110,115 @@ public:
 
     size_t read(char *buffer, size_t length) override
     {
-        py::gil_scoped_acquire gil;
-
-#if defined(PYPY_VERSION)
-        // PyPy does not permit readinto(memoryview), so read to a buffer and
-        // memcpy that buffer. Error message is:
-        // "TypeError: a read-write bytes-like object is required, not memoryview"
-        this->last_offset = this->tell();
-        py::bytes result = this->stream.attr("read")(length);
-        py::buffer pybuf(result);
-        py::buffer_info info = pybuf.request();
-        size_t bytes_read = info.size * info.itemsize;
-
-        memcpy(buffer, info.ptr, std::min(length, bytes_read));
-#else
-        auto view_buffer_info = py::memoryview::from_memory(buffer, length);
-        this->last_offset = this->tell();
-        py::object result = this->stream.attr("readinto")(view_buffer_info);
-        if (result.is_none())
+        if (this->cur_offset >= this->size) {
+            this->last_offset = this->size;
             return 0;
-        size_t bytes_read = py::cast<size_t>(result);
-#endif
-        if (bytes_read == 0) {
-            if (length > 0) {
-                // EOF
-                this->seek(0, SEEK_END);
-                this->last_offset = this->tell();
-            }
         }
-        return bytes_read;
+        this->last_offset = this->cur_offset;
+
+        // Large reads (typically stream data) bypass the cache, so they do not
+        // evict the small blocks the tokenizer keeps coming back to.
+        if (this->max_blocks == 0 || length >= this->block_size) {
+            size_t bytes_read = this->read_uncached(buffer, length, this->cur_offset);
+            this->cur_offset += QIntC::to_offset(bytes_read);
+            return bytes_read;
+        }
+
+        size_t total = 0;
+        while (total < length && this->cur_offset < this->size) {
+            auto block_index = this->cur_offset / QIntC::to_offset(this->block_size);
+            auto &block = this->get_block(block_index);
+            auto offset_in_block = QIntC::to_size(
+                this->cur_offset - block_index * QIntC::to_offset(this->block_size));
+            if (offset_in_block >= block.size())
+                break; // Stream was shorter than it claimed
+            auto n = std::min(length - total, block.size() - offset_in_block);
+            std::memcpy(buffer + total, block.data() + offset_in_block, n);
+            total += n;
+            this->cur_offset += QIntC::to_offset(n);
+        }
+        return total;
     }
 
-    void unreadCh(char ch) override { this->seek(-1, SEEK_CUR); }
+    void unreadCh(char ch) override
+    {
+        if (this->cur_offset > 0)
+            --this->cur_offset;
+    }
 
     qpdf_offset_t findAndSkipNextEOL() override
     {
-        py::gil_scoped_acquire gil; // Must acquire so another thread cannot seek
-
-        qpdf_offset_t result = 0;
-        bool eol_straddles_buf = false;
-        char rawbuf[4096];
-        std::string line_endings = "\r\n";
-
-        while (true) {
-            qpdf_offset_t cur_offset = this->tell();
-            size_t len = this->read(rawbuf, sizeof(rawbuf));
-            if (len == 0) {
-                result = this->tell();
-                break;
-            }
-            std::string_view buf(rawbuf, len);
-            size_t found;
-            if (!eol_straddles_buf) {
-                found = buf.find_first_of(line_endings);
-                if (found == std::string::npos)
-                    continue;
-            } else {
-                found = 0;
-            }
+        // Reads are small enough to be served from the block cache
+        return find_and_skip_next_eol(*this);
+    }
 
-            size_t found_end = buf.find_first_not_of(line_endings, found);
-            if (found_end == std::string::npos) {
-                eol_straddles_buf = true;
-                continue;
-            }
-            result = cur_offset + found_end;
-            this->seek(result, SEEK_SET);
-            break;
+private:
+    using Block = std::vector<char>;
+
+    Block &get_block(qpdf_offset_t block_index)
+    {
+        auto it = this->block_map.find(block_index);
+        if (it != this->block_map.end()) {
+            // Hit: move to front of LRU list
+            this->lru.splice(this->lru.begin(), this->lru, it->second);
+            return it->second->second;
         }
-        return result;
+
+        Block block(this->block_size);
+        auto bytes_read = this->read_uncached(block.data(),
+            block.size(),
+            block_index * QIntC::to_offset(this->block_size));
+        block.resize(bytes_read);
+
+        this->lru.emplace_front(block_index, std::move(block));
+        this->block_map[block_index] = this->lru.begin();
+        while (this->lru.size() > this->max_blocks) {
+            this->block_map.erase(this->lru.back().first);
+            this->lru.pop_back();
+        }
+        return this->lru.front().second;
+    }
+
+    // Read up to length bytes at offset from the Python stream.
+    size_t read_uncached(char *buffer, size_t length, qpdf_offset_t offset)
+    {
+        py::gil_scoped_acquire gil;
+        this->stream.attr("seek")(offset, SEEK_SET);
+
+        size_t total = 0;
+        while (total < length) {
+#if defined(PYPY_VERSION)
+            // PyPy does not permit readinto(memoryview), so read to a buffer and
+            // memcpy that buffer. Error message is:
+            // "TypeError: a read-write bytes-like object is required, not memoryview"
+            py::bytes result = this->stream.attr("read")(length - total);
+            py::buffer pybuf(result);
+            py::buffer_info info = pybuf.request();
+            size_t bytes_read = info.size * info.itemsize;
+            bytes_read = std::min(length - total, bytes_read);
+            memcpy(buffer + total, info.ptr, bytes_read);
+#else
+            auto view_buffer_info =
+                py::memoryview::from_memory(buffer + total, length - total);
+            py::object result = this->stream.attr("readinto")(view_buffer_info);
+            if (result.is_none())
+                break;
+            size_t bytes_read = py::cast<size_t>(result);
+#endif
+            if (bytes_read == 0)
+                break; // EOF
+            total += bytes_read;
+        }
+        return total;
     }
 
-private:
     py::object stream;
     std::string name;
     bool close;
+    size_t block_size;
+    size_t max_blocks;
+    qpdf_offset_t size = 0;
+    qpdf_offset_t cur_offset = 0;
+    std::list<std::pair<qpdf_offset_t, Block>> lru;
+    std::unordered_map<qpdf_offset_t, decltype(lru)::iterator> block_map;
 };
@@ -4,10 +4,139 @@
 #include "qpdf_pagelist.h"
 #include "pikepdf.h"
 
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include <qpdf/QPDFObjGen.hh>
 #include <qpdf/QPDFPageDocumentHelper.hh>
 #include <qpdf/QPDFPageLabelDocumentHelper.hh>
 #include <qpdf/QPDFPageObjectHelper.hh>
 
+namespace {
+
+const char *const inheritable_page_keys[] = {
+    "/Resources", "/MediaBox", "/CropBox", "/Rotate"};
+
+// Pdfs with lazy page attributes, by the unique id of their QPDF, with the pages
+// that have been accessed through Pdf.pages. Each holds a weak reference to its
+// QPDF, so that the entries of PDFs that have been freed can be swept away.
+struct LazyPages {
+    std::weak_ptr<QPDF> owner;
+    QPDFObjGen::set accessed;
+};
+
+std::mutex lazy_mutex;
+std::map<unsigned long long, LazyPages> lazy_pdfs;
+// Lets lookups skip the lock when no PDF uses lazy page attributes
+std::atomic<size_t> lazy_count{0};
+
+void note_page_access(QPDF &q, QPDFPageObjectHelper &page)
+{
+    if (lazy_count == 0)
+        return;
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    if (auto found = lazy_pdfs.find(q.getUniqueId()); found != lazy_pdfs.end())
+        found->second.accessed.add(page.getObjectHandle().getObjGen());
+}
+
+// The value of key from the nearest ancestor of page that has it
+QPDFObjectHandle ancestor_attribute(QPDFObjectHandle page, std::string const &key)
+{
+    QPDFObjGen::set visited;
+    auto node = page.getKey("/Parent");
+    while (node.isDictionary() && visited.add(node)) {
+        if (node.hasKey(key))
+            return node.getKey(key);
+        node = node.getKey("/Parent");
+    }
+    return QPDFObjectHandle::newNull();
+}
+
+} // namespace
+
+void set_lazy_page_attributes(std::shared_ptr<QPDF> q)
+{
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    std::erase_if(
+        lazy_pdfs, [](auto const &item) { return item.second.owner.expired(); });
+    lazy_pdfs[q->getUniqueId()] = LazyPages{q, {}};
+    lazy_count = lazy_pdfs.size();
+}
+
+bool has_lazy_page_attributes(QPDF &q)
+{
+    if (lazy_count == 0)
+        return false;
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    return lazy_pdfs.count(q.getUniqueId()) > 0;
+}
+
+QPDFObjectHandle inherited_page_attribute(
+    QPDFObjectHandle page, std::string const &key)
+{
+    bool inheritable = false;
+    for (auto inheritable_key : inheritable_page_keys)
+        inheritable = inheritable || key == inheritable_key;
+    if (!inheritable || page.hasKey(key))
+        return QPDFObjectHandle::newNull();
+    return ancestor_attribute(page, key);
+}
+
+LazyPageAttributesScope::LazyPageAttributesScope(QPDF &q)
+{
+    QPDFObjGen::set accessed;
+    {
+        if (lazy_count == 0)
+            return;
+        std::lock_guard<std::mutex> lock(lazy_mutex);
+        auto found = lazy_pdfs.find(q.getUniqueId());
+        if (found == lazy_pdfs.end())
+            return;
+        accessed = found->second.accessed;
+    }
+    try {
+        for (auto og : accessed) {
+            auto page = q.getObject(og);
+            if (!page.isPageObject())
+                continue;
+            for (auto key : inheritable_page_keys) {
+                auto value = inherited_page_attribute(page, key);
+                if (value.isNull())
+                    continue;
+                // Direct objects are copied so that pages do not share them
+                page.replaceKey(key, value.isIndirect() ? value : value.shallowCopy());
+                this->added.emplace_back(page, key);
+            }
+        }
+    } catch (...) {
+        this->restore();
+        throw;
+    }
+}
+
+LazyPageAttributesScope::~LazyPageAttributesScope()
+{
+    try {
+        this->restore();
+    } catch (std::exception &) {
+        // Destructors must not throw; at worst some pages keep copies of attributes
+        // they inherit, which is harmless
+    }
+}
+
+void LazyPageAttributesScope::restore()
+{
+    while (!this->added.empty()) {
+        auto [page, key] = this->added.back();
+        this->added.pop_back();
+        // Unless the write itself pushed attributes down the page tree, in which
+        // case the page must keep them
+        if (!ancestor_attribute(page, key).isNull())
+            page.removeKey(key);
+    }
+}
+
 static QPDFPageObjectHelper as_page_helper(py::handle obj)
 {
     try {
@@ -33,8 +162,11 @@ py::size_t uindex_from_index(PageList &pl, py::ssize_t index)
 QPDFPageObjectHelper PageList::get_page(py::size_t index)
 {
     auto pages = this->doc.getAllPages();
-    if (index < pages.size())
-        return pages.at(index);
+    if (index < pages.size()) {
+        auto &page = pages.at(index);
+        note_page_access(*this->qpdf, page);
+        return page;
+    }
     throw py::index_error("Accessing nonexistent PDF page number");
 }
 
@@ -171,6 +303,7 @@ QPDFPageObjectHelper PageListIterator::next()
     }
     auto page = this->pages.at(this->index);
     this->index++;
+    note_page_access(*this->pl.qpdf, page);
     return page;
 }
 
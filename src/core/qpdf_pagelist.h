@@ -5,6 +5,11 @@
 
 #include "pikepdf.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <pybind11/stl.h>
 
 #include <qpdf/QPDFPageDocumentHelper.hh>
@@ -12,6 +17,38 @@
 
 void init_pagelist(py::module_ &m);
 
+// Pdf.open(..., inherit_page_attributes='lazy'): inheritable page attributes are left
+// in the page tree when the Pdf is opened. Page properties resolve them when they are
+// read, PageList records the pages it hands out, and a save writes those pages with
+// the attributes they inherit (see LazyPageAttributesScope).
+void set_lazy_page_attributes(std::shared_ptr<QPDF> q);
+bool has_lazy_page_attributes(QPDF &q);
+
+// The value of an inheritable attribute (/Resources, /MediaBox, /CropBox or /Rotate)
+// that page does not have itself, from its nearest ancestor that has it; otherwise
+// a null handle.
+QPDFObjectHandle inherited_page_attribute(
+    QPDFObjectHandle page, std::string const &key);
+
+// For the duration of a save of a Pdf with lazy page attributes, copies the
+// inheritable attributes that the pages accessed through Pdf.pages inherit to those
+// pages, as QPDF::pushInheritedAttributesToPage() would, except that ancestors keep
+// them too. The destructor removes them again, so the Pdf is left as it was.
+// Does nothing for other Pdfs. Does not require the GIL.
+class LazyPageAttributesScope {
+public:
+    explicit LazyPageAttributesScope(QPDF &q);
+    ~LazyPageAttributesScope();
+    LazyPageAttributesScope(const LazyPageAttributesScope &) = delete;
+    LazyPageAttributesScope &operator=(const LazyPageAttributesScope &) = delete;
+
+private:
+    void restore();
+
+    // (page, key) for each attribute that was copied
+    std::vector<std::pair<QPDFObjectHandle, std::string>> added;
+};
+
 class PageList { // LCOV_EXCL_LINE
 public:
     PageList(std::shared_ptr<QPDF> q) : qpdf(q), doc(*qpdf) {};
@@ -35,6 +72,15 @@ private:
     std::vector<QPDFPageObjectHelper> get_page_objs_impl(py::slice slice);
 };
 
+inline QPDF *owning_pdf(PageList &pl) { return pl.qpdf.get(); }
+
+namespace pybind11 {
+namespace detail {
+template <>
+struct type_caster<PageList> : public pdf_checked_caster<PageList> {};
+} // namespace detail
+} // namespace pybind11
+
 class PageListIterator { // LCOV_EXCL_LINE
 public:
     PageListIterator(PageList &pl, size_t index)
@@ -0,0 +1,183 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <qpdf/Pl_Discard.hh>
+#include <qpdf/Pl_MD5.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+#include "streamcache.h"
+
+namespace {
+
+// Caches by the unique id of their QPDF. Each holds a weak reference to its QPDF,
+// so that the caches of PDFs that have been freed can be swept away.
+struct Registration {
+    std::weak_ptr<QPDF> owner;
+    std::shared_ptr<DecodedStreamCache> cache;
+};
+
+std::mutex registry_mutex;
+std::map<unsigned long long, Registration> registry;
+// Lets lookups skip the lock when no PDF has a cache, which is the usual case
+std::atomic<size_t> registry_size{0};
+
+void sweep_registry()
+{
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.owner.expired())
+            it = registry.erase(it);
+        else
+            ++it;
+    }
+    registry_size = registry.size();
+}
+
+// Everything that determines a stream's decoded data: its filters, a digest of its
+// raw data, and whether token filters have been added. Reading the raw data is
+// much cheaper than decoding it, and catches replacements that keep the same
+// length, or that are made inside qpdf. Empty if the raw data cannot be read.
+std::string fingerprint(QPDFObjectHandle &stream)
+{
+    Pl_Discard discard;
+    Pl_MD5 md5("stream cache digest", &discard);
+    try {
+        if (!stream.pipeStreamData(&md5, nullptr, 0, qpdf_dl_none, true, false))
+            return {};
+    } catch (std::exception &) {
+        return {};
+    }
+    auto dict = stream.getDict();
+    return dict.getKey("/Filter").unparseResolved() + " " +
+           dict.getKey("/DecodeParms").unparseResolved() + " " + md5.getHexDigest() +
+           (stream.isDataModified() ? " modified" : "");
+}
+
+} // namespace
+
+std::shared_ptr<Buffer> DecodedStreamCache::get(
+    QPDFObjectHandle &stream, qpdf_stream_decode_level_e level)
+{
+    auto print = fingerprint(stream);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto found = this->index.find(Key(stream.getObjGen(), level));
+    if (found == this->index.end() || print.empty() ||
+        found->second->fingerprint != print) {
+        if (found != this->index.end())
+            this->erase(found->second);
+        this->misses++;
+        return nullptr;
+    }
+    this->hits++;
+    this->entries.splice(this->entries.begin(), this->entries, found->second);
+    return found->second->data;
+}
+
+void DecodedStreamCache::put(QPDFObjectHandle &stream,
+    qpdf_stream_decode_level_e level,
+    std::shared_ptr<Buffer> data)
+{
+    // A stream too large to fit would only evict everything else
+    if (!data || data->getSize() > this->max_bytes)
+        return;
+    auto print = fingerprint(stream);
+    if (print.empty())
+        return;
+    Key key(stream.getObjGen(), level);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (auto found = this->index.find(key); found != this->index.end())
+        this->erase(found->second);
+    this->bytes += data->getSize();
+    this->entries.push_front(Entry{key, std::move(print), std::move(data)});
+    this->index[key] = this->entries.begin();
+    while (this->bytes > this->max_bytes)
+        this->erase(std::prev(this->entries.end()));
+}
+
+void DecodedStreamCache::erase(Entries::iterator it)
+{
+    this->bytes -= it->data->getSize();
+    this->index.erase(it->key);
+    this->entries.erase(it);
+}
+
+void DecodedStreamCache::forget(QPDFObjGen og)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->index.lower_bound(Key(og, qpdf_dl_none));
+    while (it != this->index.end() && it->first.first == og) {
+        auto entry = it->second;
+        ++it;
+        this->erase(entry);
+    }
+}
+
+void DecodedStreamCache::clear()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->index.clear();
+    this->entries.clear();
+    this->bytes = 0;
+}
+
+DecodedStreamCache::Stats DecodedStreamCache::stats()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Stats stats;
+    stats.hits = this->hits;
+    stats.misses = this->misses;
+    stats.entries = this->entries.size();
+    stats.bytes = this->bytes;
+    stats.max_bytes = this->max_bytes;
+    return stats;
+}
+
+void set_decoded_stream_cache(std::shared_ptr<QPDF> q, size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (max_bytes == 0)
+        registry.erase(q->getUniqueId());
+    else
+        registry[q->getUniqueId()] = {
+            q, std::make_shared<DecodedStreamCache>(max_bytes)};
+    sweep_registry();
+}
+
+std::shared_ptr<DecodedStreamCache> get_decoded_stream_cache(QPDF &q)
+{
+    if (registry_size.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto found = registry.find(q.getUniqueId());
+    if (found == registry.end()) {
+        // Reads from other PDFs are a good time to drop caches of freed PDFs
+        sweep_registry();
+        return nullptr;
+    }
+    return found->second.cache;
+}
+
+std::shared_ptr<DecodedStreamCache> get_decoded_stream_cache(QPDFObjectHandle &h)
+{
+    if (registry_size.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+    auto *owner = h.getOwningQPDF();
+    if (!owner || !h.isIndirect())
+        return nullptr;
+    return get_decoded_stream_cache(*owner);
+}
+
+void forget_decoded_stream(QPDF &q, QPDFObjGen og)
+{
+    if (auto cache = get_decoded_stream_cache(q))
+        cache->forget(og);
+}
@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <qpdf/Buffer.hh>
+#include <qpdf/Constants.h>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFObjGen.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+
+// An opt-in cache of decoded stream data for one Pdf, holding at most max_bytes of
+// the most recently read streams.
+//
+// Entries are dropped when pikepdf writes or replaces the stream. As a guard
+// against changes made inside qpdf, each entry also records the stream's /Filter,
+// /DecodeParms and a digest of its raw data, and is not used if they have changed.
+class DecodedStreamCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t max_bytes = 0;
+    };
+
+    explicit DecodedStreamCache(size_t max_bytes) : max_bytes(max_bytes) {}
+
+    // The cached data, or nullptr if the stream is not cached
+    std::shared_ptr<Buffer> get(
+        QPDFObjectHandle &stream, qpdf_stream_decode_level_e level);
+    void put(QPDFObjectHandle &stream,
+        qpdf_stream_decode_level_e level,
+        std::shared_ptr<Buffer> data);
+    void forget(QPDFObjGen og);
+    void clear();
+    Stats stats();
+
+private:
+    using Key = std::pair<QPDFObjGen, qpdf_stream_decode_level_e>;
+    struct Entry {
+        Key key;
+        std::string fingerprint;
+        std::shared_ptr<Buffer> data;
+    };
+    using Entries = std::list<Entry>;
+
+    void erase(Entries::iterator it);
+
+    std::mutex mutex;
+    size_t max_bytes;
+    size_t bytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    Entries entries;
+    std::map<Key, Entries::iterator> index;
+};
+
+// Enable the cache for a Pdf with a limit of max_bytes, or disable and discard it
+// if max_bytes is 0.
+void set_decoded_stream_cache(std::shared_ptr<QPDF> q, size_t max_bytes);
+
+// The cache for the PDF that owns an object, or nullptr if it has none.
+std::shared_ptr<DecodedStreamCache> get_decoded_stream_cache(QPDFObjectHandle &h);
+std::shared_ptr<DecodedStreamCache> get_decoded_stream_cache(QPDF &q);
+
+// Drop any cached data for an object, because it is being changed.
+void forget_decoded_stream(QPDF &q, QPDFObjGen og);
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <qpdf/Constants.h>
+#include <qpdf/DLL.h>
+#include <qpdf/InputSource.hh>
+#include <qpdf/QIntC.hh>
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QUtil.hh>
+#include <qpdf/Types.h>
+
+#include "inputsource_eol.h"
+#include "pikepdf.h"
+#include "utils.h"
+
+// An InputSource that presents another InputSource followed by some extra bytes,
+// as if they had been appended to the file.
+//
+// We use this to open a PDF with a saved xref index: the index is a complete
+// cross-reference stream, trailer and startxref, which qpdf finds at the end of
+// the "file" in place of the original ones, just as it would for an incremental
+// update. The original file is never modified.
+//
+// GIL usage:
+// This class never calls into Python itself; the wrapped InputSource manages the
+// GIL as it normally does.
+class SuffixInputSource : public InputSource {
+public:
+    SuffixInputSource(std::shared_ptr<InputSource> base, std::string suffix)
+        : InputSource(), base(base), suffix(std::move(suffix))
+    {
+        this->base->seek(0, SEEK_END);
+        this->base_size = this->base->tell();
+        this->base->seek(0, SEEK_SET);
+    }
+    virtual ~SuffixInputSource() = default;
+    // LCOV_EXCL_START
+    SuffixInputSource(const SuffixInputSource &) = delete;
+    SuffixInputSource &operator=(const SuffixInputSource &) = delete;
+    SuffixInputSource(SuffixInputSource &&) = delete;
+    SuffixInputSource &operator=(SuffixInputSource &&) = delete;
+    // LCOV_EXCL_STOP
+
+    std::string const &getName() const override { return this->base->getName(); }
+
+    qpdf_offset_t tell() override { return this->cur_offset; }
+
+    void seek(qpdf_offset_t offset, int whence) override
+    {
+        switch (whence) {
+        case SEEK_SET:
+            this->cur_offset = offset;
+            break;
+        case SEEK_END:
+            QIntC::range_check(this->size(), offset);
+            this->cur_offset = this->size() + offset;
+            break;
+        case SEEK_CUR:
+            QIntC::range_check(this->cur_offset, offset);
+            this->cur_offset += offset;
+            break;
+        default:
+            // LCOV_EXCL_START
+            throw std::logic_error(
+                "INTERNAL ERROR: invalid argument to SuffixInputSource::seek");
+            // LCOV_EXCL_STOP
+        }
+        if (this->cur_offset < 0) {
+            throw std::runtime_error(
+                this->getName() + ": seek before beginning of file");
+        }
+    }
+
+    // LCOV_EXCL_START
+    void rewind() override
+    {
+        // qpdf never seems to use this but still requires
+        this->cur_offset = 0;
+    }
+    // LCOV_EXCL_STOP
+
+    size_t read(char *buffer, size_t length) override
+    {
+        this->last_offset = this->cur_offset;
+        size_t total = 0;
+        if (this->cur_offset < this->base_size) {
+            auto n = std::min(length, QIntC::to_size(this->base_size - this->cur_offset));
+            this->base->seek(this->cur_offset, SEEK_SET);
+            total = this->base->read(buffer, n);
+            this->cur_offset += QIntC::to_offset(total);
+            if (total < n)
+                return total; // Base was shorter than it claimed
+        }
+        if (total < length && this->cur_offset >= this->base_size) {
+            auto suffix_offset = QIntC::to_size(this->cur_offset - this->base_size);
+            if (suffix_offset < this->suffix.size()) {
+                auto n = std::min(length - total, this->suffix.size() - suffix_offset);
+                std::memcpy(buffer + total, this->suffix.data() + suffix_offset, n);
+                total += n;
+                this->cur_offset += QIntC::to_offset(n);
+            }
+        }
+        return total;
+    }
+
+    void unreadCh(char ch) override
+    {
+        if (this->cur_offset > 0)
+            --this->cur_offset;
+    }
+
+    qpdf_offset_t findAndSkipNextEOL() override
+    {
+        return find_and_skip_next_eol(*this);
+    }
+
+private:
+    qpdf_offset_t size() const
+    {
+        return this->base_size + QIntC::to_offset(this->suffix.size());
+    }
+
+    std::shared_ptr<InputSource> base;
+    std::string suffix;
+    qpdf_offset_t base_size = 0;
+    qpdf_offset_t cur_offset = 0;
+};
@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2026 James R. Barlow
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed number of worker threads that run tasks from a bounded queue.
+//
+// Tasks run without the GIL and concurrently with the thread that submits them, so
+// they must not call into Python or touch QPDF or QPDFObjectHandle, neither of
+// which is thread-safe. They should only transform data that was extracted for them
+// on the submitting thread, and store results where the submitting thread will
+// collect them after wait().
+//
+// submit() blocks while the queue is full, which bounds the memory held by tasks
+// that have been prepared but not started.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned int threads, size_t max_queued = 0)
+    {
+        threads = std::max(threads, 1u);
+        this->max_queued = max_queued ? max_queued : 2 * size_t(threads);
+        for (unsigned int i = 0; i < threads; ++i)
+            this->workers.emplace_back([this] { this->run(); });
+    }
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->task_available.notify_all();
+        for (auto &worker : this->workers)
+            worker.join();
+    }
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    WorkerPool(WorkerPool &&) = delete;
+    WorkerPool &operator=(WorkerPool &&) = delete;
+
+    // Number of threads to use when the caller asks for n; n < 1 means one per CPU.
+    static unsigned int thread_count(int n)
+    {
+        if (n >= 1)
+            return static_cast<unsigned int>(n);
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    void submit(std::function<void()> task)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->space_available.wait(
+            lock, [this] { return this->tasks.size() < this->max_queued; });
+        this->tasks.push_back(std::move(task));
+        ++this->pending;
+        lock.unlock();
+        this->task_available.notify_one();
+    }
+
+    // Wait for all submitted tasks to finish. If any task threw, rethrow the first
+    // exception.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->all_done.wait(lock, [this] { return this->pending == 0; });
+        if (this->error) {
+            auto error = this->error;
+            this->error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->task_available.wait(
+                    lock, [this] { return this->stopping || !this->tasks.empty(); });
+                if (this->tasks.empty())
+                    return; // Stopping
+                task = std::move(this->tasks.front());
+                this->tasks.pop_front();
+            }
+            this->space_available.notify_one();
+
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->error)
+                    this->error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->pending == 0)
+                this->all_done.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable space_available;
+    std::condition_variable all_done;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    std::exception_ptr error;
+    size_t max_queued = 0;
+    size_t pending = 0;
+    bool stopping = false;
+};
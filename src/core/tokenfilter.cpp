@@ -19,6 +19,8 @@ public:
 
     void handleToken(Token const &token) override
     {
+        // May be called while saving, with the GIL released
+        py::gil_scoped_acquire gil;
         py::object result = this->handle_token(token);
         if (result.is_none())
             return;
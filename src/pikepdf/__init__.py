@@ -22,6 +22,7 @@ from pikepdf._core import (
     Annotation,
     AnnotationFlag,
     AttachedFileSpec,
+    CancellationToken,
     ContentStreamInlineImage,
     ContentStreamInstruction,
     DataDecodingError,
@@ -35,6 +36,7 @@ from pikepdf._core import (
     NumberTree,
     ObjectHelper,
     ObjectStreamMode,
+    OperationCancelledError,
     Page,
     PasswordError,
     Pdf,
@@ -65,13 +67,17 @@ from pikepdf.objects import (
     String,
 )
 from pikepdf.models import (
+    CompressionPolicy,
     Encryption,
+    ExtractedImage,
     Outline,
     OutlineItem,
     PageLocation,
     PdfImage,
     PdfInlineImage,
     Permissions,
+    ProgressEvent,
+    extract_all_images,
     make_page_destination,
     parse_content_stream,
     unparse_content_stream,
@@ -120,6 +126,8 @@ __all__ = [
     'Array',
     'AttachedFileSpec',
     'Boolean',
+    'CancellationToken',
+    'CompressionPolicy',
     'ContentStreamInlineImage',
     'ContentStreamInstruction',
     'DataDecodingError',
@@ -129,6 +137,8 @@ __all__ = [
     'Encryption',
     'exceptions',
     'explicit_conversion',
+    'ExtractedImage',
+    'extract_all_images',
     'ForeignObjectError',
     'FormFieldFlag',
     'get_object_conversion_mode',
@@ -149,6 +159,7 @@ __all__ = [
     'ObjectHelper',
     'ObjectStreamMode',
     'ObjectType',
+    'OperationCancelledError',
     'Operator',
     'Outline',
     'OutlineItem',
@@ -162,6 +173,7 @@ __all__ = [
     'PdfImage',
     'PdfInlineImage',
     'Permissions',
+    'ProgressEvent',
     'Real',
     'Rectangle',
     'set_object_conversion_mode',
@@ -8,8 +8,10 @@ from __future__ import annotations
 # pikepdf/_methods.py. Thus, we need to manually spell out the resulting types
 # after augmenting.
 import datetime
+import os
 from abc import abstractmethod
 from collections.abc import (
+    AsyncIterator,
     Callable,
     Collection,
     Iterable,
@@ -21,6 +23,7 @@ from collections.abc import (
 )
 from decimal import Decimal
 from enum import Enum, IntFlag
+from io import RawIOBase
 from pathlib import Path
 from typing import (
     TYPE_CHECKING,
@@ -35,6 +38,8 @@ from typing import (
 if TYPE_CHECKING:
     import numpy as np
 
+    from pikepdf.models.compression import CompressionPolicy
+    from pikepdf.models.progress import ProgressEvent
     from pikepdf.models.encryption import Encryption, EncryptionInfo, Permissions
     from pikepdf.models.image import PdfInlineImage
     from pikepdf.models.metadata import PdfMetadata
@@ -106,11 +111,21 @@ class DeletedObjectError(Exception):
     .. versionadded:: 7.0
     """
 
+class OperationCancelledError(PdfError):
+    """An operation stopped because its :class:`CancellationToken` was cancelled.
+
+    Also raised when the token's time budget runs out.
+
+    .. versionadded:: 10.3
+    """
+
 # Enums
 class AccessMode(Enum):
+    buffer: ...
     default: ...
     mmap: ...
     mmap_only: ...
+    pread: ...
     stream: ...
 
 class AnnotationFlag(IntFlag):
@@ -512,13 +527,73 @@ class Object:
     def items(self) -> Iterable[tuple[str, Object]]: ...
     def keys(self) -> set[str]:
         """Get the keys of the object, if it is a Dictionary or Stream."""
+    def open_decoded(
+        self,
+        decode_level: StreamDecodeLevel = ...,
+        *,
+        chunk_size: int = 65536,
+        max_chunks: int = 16,
+    ) -> RawIOBase:
+        """Open the stream's decoded data as a read-only binary file.
+
+        Unlike :meth:`read_bytes`, the decoded data is never held in memory all
+        at once. The stream's raw data is copied when the reader is opened, then
+        decoded on a background thread, without the GIL, into a queue of at
+        most *max_chunks* chunks of *chunk_size* bytes, waiting whenever the
+        queue is full. So memory use is bounded by the raw size however large
+        the decoded data is, and the data can be copied to a file or socket
+        with :func:`shutil.copyfileobj` or ``readinto()``.
+
+        The background thread only uses its copy, so the :class:`Pdf` may be
+        used or modified while the reader is open. Streams whose decoding needs
+        the Pdf, such as those with indirect decode parameters or JBIG2 images
+        decoded through Python, are decoded in full when the reader is opened.
+        Errors in decoding the stream are raised when the reader reaches them.
+        Closing the reader early stops decoding.
+
+        Args:
+            decode_level: How far to decode, as for :meth:`read_bytes`.
+            chunk_size: Size of the chunks passed from the decoder.
+            max_chunks: Number of chunks that may be waiting to be read.
+
+        .. versionadded:: 10.3
+        """
     @staticmethod
     def parse(stream: bytes, description: str = ...) -> Object:
         """Parse PDF binary representation into PDF objects."""
-    def read_bytes(self, decode_level: StreamDecodeLevel = ...) -> bytes:
-        """Decode and read the content stream associated with this object."""
-    def read_raw_bytes(self) -> bytes:
-        """Read the content stream associated with a Stream, without decoding."""
+    @overload
+    def read_bytes(
+        self, decode_level: StreamDecodeLevel = ..., *, copy: Literal[True] = ...
+    ) -> bytes:
+        """Decode and read the content stream associated with this object.
+
+        Args:
+            decode_level: How far to decode the stream.
+            copy: If ``False``, return a read-only :class:`memoryview` of the
+                decoded data instead of copying it into :class:`bytes`. The view
+                keeps the data alive, and halves peak memory when passing large
+                streams to libraries that accept the buffer protocol.
+
+        .. versionchanged:: 10.3
+            Added *copy*.
+        """
+    @overload
+    def read_bytes(
+        self, decode_level: StreamDecodeLevel = ..., *, copy: Literal[False]
+    ) -> memoryview: ...
+    @overload
+    def read_raw_bytes(self, *, copy: Literal[True] = ...) -> bytes:
+        """Read the content stream associated with a Stream, without decoding.
+
+        Args:
+            copy: If ``False``, return a read-only :class:`memoryview` of the
+                raw data instead of copying it into :class:`bytes`.
+
+        .. versionchanged:: 10.3
+            Added *copy*.
+        """
+    @overload
+    def read_raw_bytes(self, *, copy: Literal[False]) -> memoryview: ...
     def same_owner_as(self, other: Object) -> bool:
         """Test if two objects are owned by the same :class:`pikepdf.Pdf`."""
     def to_json(self, dereference: bool = ..., schema_version: int = ...) -> bytes:
@@ -769,6 +844,46 @@ class _ObjectList:
     @overload
     def __setitem__(*args, **kwargs) -> Any: ...
 
+class CancellationToken:
+    """Stops a long-running operation from another thread or after a time limit.
+
+    Pass a token to :meth:`Pdf.save`, :meth:`Pdf.check_pdf_syntax` or
+    :meth:`Job.run`. Those operations release the GIL while they work, so another
+    thread may call :meth:`cancel`. The operation notices at its next check and
+    raises :class:`OperationCancelledError`.
+
+    A token cannot be reset. Use a new token for each operation that should have
+    its own time budget.
+
+    .. versionadded:: 10.3
+    """
+
+    def __init__(self, timeout: float | None = None) -> None:
+        """Create a token.
+
+        Args:
+            timeout: If given, the token counts as cancelled once this many
+                seconds have passed since it was created.
+        """
+    def cancel(self) -> None:
+        """Ask the operations using this token to stop. Thread-safe."""
+    @property
+    def cancelled(self) -> bool:
+        """Whether the token was cancelled or its time budget has run out."""
+    @property
+    def remaining(self) -> float | None:
+        """Seconds left in the time budget, or None if there is no timeout."""
+    def check(self) -> None:
+        """Raise :class:`OperationCancelledError` if the token is cancelled."""
+
+class _OutputChunkQueue:
+    """Bounded queue of output chunks used by Pdf.iter_save."""
+
+    def __init__(self, chunk_size: int, max_chunks: int) -> None: ...
+    def get(self) -> bytes | None: ...
+    def close(self) -> None: ...
+    def cancel(self) -> None: ...
+
 class _ObjectMapping:
     """A mapping whose keys and values are always pikepdf.Name and pikepdf.Object."""
 
@@ -1452,6 +1567,9 @@ class Page:
     def _get_cropbox(self, arg0: bool, arg1: bool) -> Object: ...
     def _get_mediabox(self, arg0: bool) -> Object: ...
     def _get_trimbox(self, arg0: bool, arg1: bool) -> Object: ...
+    @property
+    def _lazy_inheritance(self) -> bool: ...
+    def _lazy_inherited_attribute(self, key: str, copy: bool = False) -> Object: ...
     def add_content_token_filter(self, tf: TokenFilter) -> None:
         """Attach a :class:`pikepdf.TokenFilter` to a page's content stream.
 
@@ -1794,6 +1912,11 @@ class Page:
             If the resources dictionary does not exist, an empty one will be created.
             A TypeError is raised if a page has a /Resources key but it is not a
             dictionary.
+
+        .. versionchanged:: 10.3
+            If the Pdf was opened with ``inherit_page_attributes='lazy'`` and the
+            page inherits its resources from the page tree, they are copied to
+            the page instead of creating an empty dictionary.
         """
     def add_resource(
         self,
@@ -1978,14 +2101,26 @@ class Pdf:
             first: If True, prepend this before the first page;
                 if False append after last page.
         """
-    def _decode_all_streams_and_discard(self, progress) -> None: ...
+    def _decode_all_streams_and_discard(
+        self,
+        progress=...,
+        progress_event=...,
+        cancellation_token=...,
+    ) -> None: ...
+    def _xref_index(self, offset: int) -> bytes: ...
     def _get_object_id(self, arg0: int, arg1: int) -> Object: ...
     def _process(self, arg0: str, arg1: bytes) -> None: ...
     def _remove_page(self, arg0: Object) -> None: ...
-    def _replace_object(self, arg0: tuple[int, int], arg1: Object) -> None: ...
+    def _collect_images(self) -> list[tuple[Stream, str, list[int]]]: ...
+    def _replace_object(self, arg0: tuple[int, int], arg1: Object | None) -> None: ...
     def _swap_objects(self, arg0: tuple[int, int], arg1: tuple[int, int]) -> None: ...
     def check_pdf_syntax(
-        self, progress: Callable[[int], None] | None = ...
+        self,
+        progress: Callable[[int], None] | None = ...,
+        *,
+        progress_event: Callable[[ProgressEvent], None] | None = ...,
+        cancellation_token: CancellationToken | None = ...,
+        threads: int | None = ...,
     ) -> list[str]:
         """Check if PDF is syntactically well-formed.
 
@@ -2018,10 +2153,117 @@ class Pdf:
         Args:
             progress: A function to call with progress updates, from 0 to 100.
                 If None (default), no progress will be reported.
+            progress_event: A function to call with a :class:`pikepdf.ProgressEvent`
+                as streams are decoded, with phase ``'decode'``.
+            cancellation_token: If cancelled, or if its time budget runs out,
+                the check stops and raises :class:`pikepdf.OperationCancelledError`.
+            threads: If not None, decode streams with :meth:`validate_streams`
+                on this many threads (0 for one per CPU) instead of in a single
+                pass, and report each stream that fails to decode. Progress is
+                not reported in this mode.
 
         Returns:
             Empty list if no issues were found. List of issues as text strings
             if issues were found.
+
+        .. versionchanged:: 10.3
+            Added *progress_event*, *cancellation_token* and *threads*.
+        """
+    def validate_streams(
+        self,
+        *,
+        threads: int = 0,
+        cancellation_token: CancellationToken | None = None,
+    ) -> list[dict[str, Any]]:
+        """Decode every stream in the PDF, and report those that fail.
+
+        Each stream's raw data is read on the calling thread and then decoded,
+        with all filters including lossy ones, on a pool of worker threads. The
+        GIL is released throughout, except for JBIG2 streams, which are decoded
+        on the calling thread because the JBIG2 decoder runs in Python. If no
+        JBIG2 decoder is available, a warning is issued and JBIG2 streams are not
+        checked, as with :meth:`check_pdf_syntax`.
+
+        The decoded data is discarded, so memory use is bounded by the size of
+        the largest few streams.
+
+        Args:
+            threads: Number of worker threads. 0 uses one per CPU.
+            cancellation_token: Checked before each stream.
+
+        Returns:
+            A list with a dictionary for each stream that could not be decoded,
+            in object order, with the stream's ``objgen``, its ``filter`` and the
+            ``error``. An empty list means all streams decoded.
+
+        .. versionadded:: 10.3
+        """
+    def enable_decoded_stream_cache(self, max_bytes: int = 67108864) -> None:
+        """Cache the decoded data of streams read from this PDF.
+
+        While enabled, :meth:`Object.read_bytes` keeps the decoded data of the
+        streams it reads, up to *max_bytes* in total, and returns the cached data
+        when the same stream is read again at the same decode level. The least
+        recently used streams are dropped first. This helps when the same fonts,
+        Form XObjects or content streams are read many times.
+
+        A stream's entry is dropped when it is written with :meth:`Stream.write`,
+        or replaced or swapped with another object. Each read also checks the
+        stream's ``/Filter``, ``/DecodeParms`` and a digest of its raw data, so
+        that data changed by other means, such as by qpdf itself, is decoded
+        again. Reading the raw data is much cheaper than decoding it.
+
+        Enabling the cache again replaces it with an empty one.
+
+        Args:
+            max_bytes: Most decoded data to keep. Streams larger than this are
+                never cached.
+
+        .. versionadded:: 10.3
+        """
+    def disable_decoded_stream_cache(self) -> None:
+        """Stop caching decoded stream data, and discard the cache.
+
+        .. versionadded:: 10.3
+        """
+    @property
+    def decoded_stream_cache_stats(self) -> dict[str, int] | None:
+        """Counters for the decoded stream cache, or ``None`` if it is disabled.
+
+        The dictionary has the number of ``hits`` and ``misses``, the number of
+        ``entries`` and ``bytes`` held, and the ``max_bytes`` limit.
+
+        .. versionadded:: 10.3
+        """
+    def read_streams(
+        self,
+        objects: Iterable[Object],
+        *,
+        decode_level: StreamDecodeLevel = StreamDecodeLevel.generalized,
+        threads: int = 0,
+    ) -> list[bytes | Exception]:
+        """Decode several streams at once, as :meth:`Object.read_bytes` would.
+
+        Each stream's raw data is read on the calling thread and then decoded
+        on a pool of worker threads with the GIL released. JBIG2 streams are
+        decoded on the calling thread, because the JBIG2 decoder runs in Python.
+        The streams may belong to any :class:`Pdf`.
+
+        A stream that cannot be decoded does not stop the others. Instead, its
+        place in the result holds the exception, much like
+        :func:`asyncio.gather` with ``return_exceptions=True``.
+
+        Args:
+            objects: The streams to decode.
+            decode_level: How far to decode, as for :meth:`Object.read_bytes`.
+            threads: Number of worker threads. 0 uses one per CPU.
+
+        Returns:
+            A list in the same order as ``objects``, holding for each either
+            the decoded data, or the :class:`PdfError` (or :class:`TypeError`
+            for objects that are not streams) raised in decoding it.
+
+        .. versionadded:: 10.3
         """
     def check_linearization(self, stream: object = ...) -> bool:
         """Reports information on the PDF's linearization.
@@ -2168,16 +2410,17 @@ class Pdf:
         """
     @staticmethod
     def open(
-        filename_or_stream: Path | str | BinaryIO,
+        filename_or_stream: Path | str | BinaryIO | bytearray | memoryview,
         *,
         password: str | bytes = '',
         hex_password: bool = False,
         ignore_xref_streams: bool = False,
         suppress_warnings: bool = True,
         attempt_recovery: bool = True,
-        inherit_page_attributes: bool = True,
+        inherit_page_attributes: bool | Literal['lazy'] = True,
         access_mode: AccessMode = AccessMode.default,
         allow_overwriting_input: bool = False,
+        xref_index: bool | str | os.PathLike = False,
     ) -> Pdf:
         """Open an existing file at *filename_or_stream*.
 
@@ -2193,6 +2436,12 @@ class Pdf:
         ``stream.close()``, in that order, when the Pdf and stream are no longer needed.
         Use with-blocks will call ``.close()`` automatically.
 
+        If *filename_or_stream* is a ``bytearray`` or ``memoryview``, or
+        ``access_mode=AccessMode.buffer`` is given, it may be any object that supports
+        the buffer protocol, such as ``bytes`` or a contiguous numpy array. The PDF is
+        read directly from the object's memory without copying it, and the object is
+        kept alive until the Pdf is closed.
+
         Whether a file or stream is opened, you must ensure that the data is not
         modified by another thread or process, or undefined behavior will occur. You
         also may not overwrite the input file using ``.save()``, unless
@@ -2229,7 +2478,24 @@ class Pdf:
             attempt_recovery: If True (default), attempt to recover
                 from PDF parsing errors.
             inherit_page_attributes: If True (default), push attributes
-                set on a group of pages to individual pages
+                set on a group of pages to individual pages. This visits every
+                page in the document when it is opened. If ``'lazy'``, the
+                inheritable attributes (``/Resources``, ``/MediaBox``, ``/CropBox``
+                and ``/Rotate``) are left where they are, which makes opening large
+                documents faster when only a few pages are used. Reading a page
+                does not change it: :class:`Page` resolves inherited attributes
+                when they are read, through properties such as
+                :attr:`Page.mediabox` or as ``page.Rotate``, ``page['/Rotate']``
+                and ``page.get('/Rotate')``. Inherited values are shared with the
+                page tree, so set a new value on the page rather than modifying
+                one in place; :attr:`Page.resources` is the exception, and copies
+                inherited resources to the page so that they can be modified.
+                Code that reads ``page.obj`` directly sees only the page's own
+                attributes. When the Pdf is saved, the pages that were accessed
+                through :attr:`Pdf.pages` are written with the attributes they
+                inherit; the Pdf itself is not changed. qpdf pushes attributes to
+                every page if pages are inserted, removed or copied to another
+                Pdf, or the file is linearized.
             access_mode: If ``.default``, pikepdf will
                 decide how to access the file. Currently, it will always selected stream
                 access. To attempt memory mapping and fallback to stream if memory
@@ -2237,10 +2503,26 @@ class Pdf:
                 mapping or fail (this is expected to only be useful for testing).
                 Applications should be prepared to handle the SIGBUS signal on POSIX in
                 the event that the file is successfully mapped but later goes away.
+                On POSIX, memory mapped files are hinted for random access while
+                objects are being resolved, and for sequential access while saving.
+                Use ``.pread`` to read a regular file directly through its operating
+                system file descriptor, without calling back into Python and with
+                the GIL released; if the file has no usable file descriptor, pikepdf
+                falls back to stream access. On Windows ``.pread`` is equivalent to
+                ``.stream``. Use ``.buffer`` to open an object that supports the
+                buffer protocol without copying it.
             allow_overwriting_input: If True, allows calling ``.save()``
                 to overwrite the input file. This is performed by loading the entire
                 input file into memory at open time; this will use more memory and may
                 recent performance especially when the opened file will not be modified.
+            xref_index: If True, or the path of an index file, use a saved
+                cross-reference index to open the file without parsing its
+                cross-reference sections or repeating recovery. If the index is
+                missing or stale, the file is opened normally and the index is
+                saved for next time. If True, the index is kept next to the file
+                (see :func:`pikepdf.xref_index.default_index_path`). Requires
+                *filename_or_stream* to be a path. Ignored if
+                *ignore_xref_streams* is True.
 
         Raises:
             pikepdf.PasswordError: If the password failed to open the
@@ -2262,6 +2544,10 @@ class Pdf:
         .. versionchanged:: 3.0
             Keyword arguments now mandatory for everything except the first
             argument.
+
+        .. versionchanged:: 10.3
+            Added ``AccessMode.pread`` and ``AccessMode.buffer``,
+            ``inherit_page_attributes='lazy'`` and ``xref_index``.
         """
     def open_metadata(
         self,
@@ -2356,6 +2642,27 @@ class Pdf:
         Suggested before saving, if content streams or /Resources dictionaries
         are edited.
         """
+    def deduplicate_streams(self) -> dict[str, int]:
+        """Merge streams with identical data and dictionaries into one object.
+
+        Every stream's raw (encoded) data is hashed as it is read, without holding
+        the GIL, and only the data of streams with the same hash is kept for
+        comparison. Streams whose data and dictionary (ignoring
+        ``/Length`` and key order) are identical are merged: all references to
+        the duplicates are changed to refer to the first such stream, and the
+        duplicates are deleted. Merging is repeated so that streams which differ
+        only in references to duplicate streams, such as images with identical
+        soft masks, are merged too.
+
+        PDFs assembled from other PDFs often contain many copies of the same fonts,
+        images and ICC profiles; run this before saving to write each only once.
+
+        Returns:
+            A dictionary with the number of ``streams`` examined, the number of
+            ``duplicates`` removed, and the ``bytes_saved`` of raw stream data.
+
+        .. versionadded:: 10.3
+        """
     def save(
         self,
         filename_or_stream: Path | str | BinaryIO | None = None,
@@ -2375,6 +2682,11 @@ class Pdf:
         encryption: Encryption | bool | None = None,
         recompress_flate: bool = False,
         deterministic_id: bool = False,
+        compress_threads: int | None = None,
+        compression_policy: CompressionPolicy | None = None,
+        incremental: bool = False,
+        progress_event: Callable[[ProgressEvent], None] | None = None,
+        cancellation_token: CancellationToken | None = None,
     ) -> None:
         """Save all modifications to this :class:`pikepdf.Pdf`.
 
@@ -2494,10 +2806,70 @@ class Pdf:
                 the same inputs are converted in the same way multiple times.
                 Does not work for encrypted files.
 
+            compress_threads: If not None, compress stream data on this many
+                worker threads (0 for one per CPU) before writing, instead of
+                one stream at a time as the file is written. Only streams that
+                would otherwise be compressed during the save are affected, so
+                this has no effect with ``compress_streams=False``, ``qdf=True``
+                or ``normalize_content=True``. The output does not depend on the
+                number of threads, but it is not byte-for-byte identical to the
+                output with ``compress_threads=None``, because the stream
+                dictionaries of pre-compressed streams are written with their
+                keys in a different order. The compressed data of each stream is
+                held in memory until it is written, and afterwards the stream
+                keeps its original data in memory instead of reading it from the
+                file again.
+
+            compression_policy: If set, each stream that would be compressed
+                is sampled, written uncompressed if compressing it is not
+                expected to save enough, and otherwise compressed at a level
+                chosen by its class (content stream, font, image or other) and
+                size. See :class:`pikepdf.CompressionPolicy`. The decision for
+                each stream is reported in ``last_save_stats`` under
+                ``compression_decisions``. Has no effect when streams would not
+                be compressed anyway, as with ``compress_streams=False``,
+                ``qdf=True`` or ``normalize_content=True``. The level set with
+                :func:`pikepdf.settings.set_flate_compression_level` is not
+                changed. If pikepdf was built without zlib (``PIKEPDF_WITH_ZLIB``
+                is off by default on Windows), streams are compressed at that
+                level whatever the policy's levels, and the decisions report -1.
+
+            incremental: If True, write the PDF as an incremental update: the
+                bytes the Pdf was opened from, unchanged, followed by only the
+                objects that were modified or added, a new cross-reference
+                section and a new trailer. Existing digital signatures remain
+                valid over the original bytes. If the destination is the file or
+                stream the Pdf was opened from, the update is appended to it in
+                place. The Pdf must have been opened from a file, stream or
+                buffer, and must not be encrypted. Objects are found to be
+                modified by comparing them with the original file, reopened
+                with the same ``inherit_page_attributes`` setting as the Pdf.
+                Only ``compress_streams``, which applies to new and modified
+                streams, affects the update. ``linearize``, ``qdf``,
+                ``normalize_content``, ``encryption`` and the options that
+                configure the writer, such as ``object_stream_mode``,
+                ``static_id``, ``min_version``, ``progress`` and
+                ``compress_threads``, raise :class:`ValueError`.
+
+            progress_event: Like ``progress``, but called with a
+                :class:`pikepdf.ProgressEvent`, which also reports the objects
+                and bytes written so far and the elapsed time, from which
+                throughput can be measured. The same restrictions apply.
+
+            cancellation_token: A :class:`pikepdf.CancellationToken` that is
+                checked while the PDF is written: at each percent of progress,
+                before each stream is compressed with ``compress_threads``, and
+                before each chunk of output is written. If it has been cancelled
+                from another thread, or its time budget has run out, the save
+                stops and raises :class:`pikepdf.OperationCancelledError`. The
+                destination is then incomplete; a destination file is deleted,
+                or left as it was if it already existed.
+
         Raises:
             PdfError
             ForeignObjectError
             ValueError
+            OperationCancelledError
 
         You may call ``.save()`` multiple times with different parameters
         to generate different versions of a file, and you *may* continue
@@ -2547,6 +2919,67 @@ class Pdf:
             The modified time is always set to the time of saving. An unusual
             umask or other settings changes still cause a failure to restore
             permissions.
+
+        .. versionchanged:: 10.3
+            When the destination is a file path or a plain file object backed by
+            a regular file (on POSIX), output is written to its file descriptor
+            directly instead of through the stream's ``write()``, and the GIL is
+            released while the PDF is written, so other Python threads can run.
+            While the save runs, using this Pdf or its objects from another
+            thread raises :exc:`RuntimeError`. Other streams are written holding
+            the GIL. Streams need not be
+            seekable or readable, so pipes and sockets may be used; see also
+            :meth:`iter_save`.
+
+        .. versionadded:: 10.3
+            Added *compress_threads*, *compression_policy*, *incremental*,
+            *progress_event* and *cancellation_token*.
+        """
+    def iter_save(
+        self, *, chunk_size: int = 65536, max_chunks: int = 16, **save_options: Any
+    ) -> Iterator[bytes]:
+        """Save this PDF as an iterator of chunks of bytes.
+
+        Use this to send a PDF somewhere that cannot be given a stream, such as
+        the body of a streaming HTTP response. The PDF is written on a background
+        thread, which waits whenever ``max_chunks`` chunks are ready but have not
+        been taken from the iterator, so memory use stays around
+        ``chunk_size * max_chunks`` bytes however large the PDF is.
+
+        The save begins when the first chunk is requested. If the iterator is
+        closed or discarded before it is exhausted, the save is abandoned. If the
+        save fails, the exception is raised from the iterator after the chunks
+        written so far. :attr:`last_save_stats` is set when the save completes.
+
+        The background thread writes without holding the GIL, so the consumer
+        and other threads keep running. Until the iterator is exhausted or
+        closed, using this Pdf or its objects from any other thread raises
+        :exc:`RuntimeError`, since the Pdf cannot be used by two threads at once.
+
+        Args:
+            chunk_size: Size of each chunk, except the last, which may be smaller.
+            max_chunks: Number of chunks that may be waiting to be taken.
+            **save_options: Any keyword arguments of :meth:`save`, except
+                ``incremental``.
+
+        .. versionadded:: 10.3
+        """
+    def aiter_save(
+        self, *, chunk_size: int = 65536, max_chunks: int = 16, **save_options: Any
+    ) -> AsyncIterator[bytes]:
+        """Save this PDF as an asynchronous iterator of chunks of bytes.
+
+        The same as :meth:`iter_save`, but waiting for each chunk does not block
+        the event loop. For example, to write a PDF to an asyncio stream with
+        flow control:
+
+        .. code-block:: python
+
+            async for chunk in pdf.aiter_save():
+                writer.write(chunk)
+                await writer.drain()
+
+        .. versionadded:: 10.3
         """
     def show_xref_table(self) -> None:
         """Pretty-print the Pdf's xref (cross-reference table).
@@ -2664,6 +3097,21 @@ class Pdf:
         parameter dictionary.  Does no additional validation.
         """
     @property
+    def last_save_stats(self) -> dict[str, int] | None:
+        """Statistics on how the most recent :meth:`save` wrote its output.
+
+        A dictionary with ``bytes_written``, the size of the output;
+        ``chunks``, the number of pieces of output qpdf produced;
+        ``stream_writes``, the number of calls to the output stream's ``write()``
+        (or to the operating system, if writing directly), which is much smaller
+        than ``chunks`` when output is buffered (see
+        :func:`pikepdf.settings.set_output_buffer_size`); and ``direct``, True if
+        output was written directly to a file descriptor. None if this Pdf has not
+        been saved.
+
+        .. versionadded:: 10.3
+        """
+    @property
     def objects(self) -> _ObjectList:
         """Return an iterable list of all objects in the PDF.
 
@@ -3059,8 +3507,28 @@ class Job:
     @property
     def message_prefix(self) -> str:
         """Allows manipulation of the prefix in front of all output messages."""
-    def run(self) -> None:
-        """Executes the job."""
+    def run(
+        self,
+        *,
+        progress_event: Callable[[ProgressEvent], None] | None = None,
+        cancellation_token: CancellationToken | None = None,
+    ) -> None:
+        """Executes the job.
+
+        Args:
+            progress_event: A function to call with a :class:`pikepdf.ProgressEvent`
+                as the job writes its output, with phase ``'job'``.
+            cancellation_token: Checked as the job writes its output; if
+                cancelled, or its time budget runs out, the job stops and raises
+                :class:`pikepdf.OperationCancelledError`.
+
+        Either argument enables ``--progress`` for this run only. Afterwards the
+        job reports progress as it did before: through logging if it was
+        configured with ``--progress``, otherwise not at all.
+
+        .. versionchanged:: 10.3
+            Added *progress_event* and *cancellation_token*.
+        """
     def create_pdf(self):
         """Executes the first stage of the job."""
     def write_pdf(self, pdf: Pdf):
@@ -3359,6 +3827,29 @@ def set_decimal_precision(prec: int) -> int:
 def unparse(obj: Any) -> bytes: ...
 def utf8_to_pdf_doc(utf8: str, unknown: bytes) -> tuple[bool, bytes]: ...
 def _unparse_content_stream(contentstream: Iterable[Any]) -> bytes: ...
+def _jbig2dec_native_available() -> bool: ...
+def _per_stream_compression_levels() -> bool: ...
+def _jbig2dec_decode(data: bytes, globals: bytes) -> bytes: ...
+def _set_jbig2_native_decoding(enabled: bool) -> None: ...
+def _jbig2_cache_stats() -> dict[str, int]: ...
+def _jbig2_cache_clear() -> None: ...
+def _unpack_subbyte_pixels(
+    packed: bytes | bytearray | memoryview,
+    out: bytearray | memoryview,
+    bits: int,
+    scale: float,
+    invert: bool,
+) -> None: ...
+def _expand_palette(
+    packed: bytes | bytearray | memoryview,
+    out: Any,
+    width: int,
+    height: int,
+    bits: int,
+    palette: bytes | bytearray | memoryview,
+    components: int,
+) -> None: ...
+def _image_kernel_isa() -> str: ...
 def set_flate_compression_level(
     level: Literal[-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9],
 ) -> int:
@@ -3367,3 +3858,100 @@ def set_flate_compression_level(
     Args:
         level: -1 (default), 0 (no compression), 1 to 9 (increasing compression)
     """
+
+def get_mmap_populate_threshold() -> int:
+    """Return the largest file size, in bytes, that is prefaulted when mapped."""
+
+def set_mmap_populate_threshold(nbytes: int) -> int:
+    """Prefault memory mapped files up to *nbytes* in size.
+
+    When a file no larger than *nbytes* is opened with ``AccessMode.mmap``, the whole
+    file is read into the page cache while it is mapped (``MAP_POPULATE``), avoiding
+    page fault stalls later. Larger files are mapped lazily. The default is 0, which
+    disables prefaulting. Only has an effect on Linux.
+
+    Returns:
+        The previous threshold.
+    """
+
+def get_stream_read_cache() -> tuple[int, int]:
+    """Return the ``(block_size, max_blocks)`` of the stream read cache."""
+
+def set_stream_read_cache(
+    block_size: int = 65536, max_blocks: int = 16
+) -> tuple[int, int]:
+    """Configure the read cache used when a PDF is opened from a Python stream.
+
+    When a PDF is opened with stream access, pikepdf reads the stream in blocks of
+    *block_size* bytes and keeps up to *max_blocks* of the most recently used
+    blocks in memory, so that most of qpdf's small reads do not call into Python.
+    The setting applies to PDFs opened after it is changed.
+
+    Args:
+        block_size: Size of each cached block in bytes; at least 512.
+        max_blocks: Number of blocks to keep per open PDF. Use 0 to disable the
+            cache and call into Python on every read.
+
+    Returns:
+        The previous ``(block_size, max_blocks)``.
+    """
+
+def get_flate_backend() -> str:
+    """Return the name of the flate implementation in use."""
+
+def get_flate_backends() -> list[str]:
+    """Return the names of the available flate implementations.
+
+    ``"zlib"``, qpdf's own implementation, is always available. ``"libdeflate"`` is
+    available if pikepdf was built with libdeflate.
+    """
+
+def set_flate_backend(name: str) -> str:
+    """Select the flate implementation used to compress and decompress streams.
+
+    Flate (``/FlateDecode``) is the most common PDF compression method, and often
+    the largest cost of reading and saving PDFs. By default pikepdf uses qpdf's
+    zlib-based implementation. Other implementations, such as libdeflate, work on
+    whole streams at once and are considerably faster.
+
+    When a backend other than ``"zlib"`` is selected, it decompresses flate
+    streams, for example in :meth:`pikepdf.Stream.read_bytes`, falling back to
+    zlib for damaged streams that it rejects. Saving with ``compress_threads`` or
+    ``compression_policy`` in :meth:`pikepdf.Pdf.save` also compresses streams
+    with it; the output is valid flate data but is not byte-for-byte the same as
+    zlib's. Other saves compress with zlib as usual.
+
+    The setting affects the whole process. Selecting ``"zlib"`` again restores
+    qpdf's decoding pipeline.
+
+    zlib-ng, when used as a drop-in replacement for zlib when building qpdf, is
+    used as ``"zlib"``.
+
+    Args:
+        name: One of :func:`get_flate_backends`.
+
+    Returns:
+        The name of the previously selected backend.
+
+    Raises:
+        ValueError: If there is no backend of that name.
+
+    .. versionadded:: 10.3
+    """
+
+def get_output_buffer_size() -> int:
+    """Return the size of the buffer used when saving PDFs to Python streams."""
+
+def set_output_buffer_size(nbytes: int = 1048576) -> int:
+    """Set the size of the buffer used when saving PDFs to Python streams.
+
+    qpdf produces its output in many small pieces, such as object headers and
+    ``endobj`` markers. When saving, pikepdf collects these pieces in a buffer of
+    *nbytes* and passes them to the stream's ``write()`` in large chunks, so that
+    saving is not dominated by the cost of calling into Python. Pieces at least as
+    large as the buffer are written directly. Use 0 to write every piece as it is
+    produced. The default is 1 MiB.
+
+    Returns:
+        The previous buffer size.
+    """
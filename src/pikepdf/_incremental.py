@@ -0,0 +1,143 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Incremental updates, which append the changes to a PDF to its original bytes.
+
+An incremental update contains only the objects that differ from the original file,
+a cross-reference section for them and a new trailer that links back to the
+original's last cross-reference section. The original bytes are kept exactly as
+they were, which preserves any digital signatures over them.
+"""
+
+from __future__ import annotations
+
+import os
+import shutil
+from contextlib import ExitStack
+from io import BytesIO
+from pathlib import Path
+from typing import BinaryIO
+
+from pikepdf._core import Pdf
+from pikepdf._io import atomic_overwrite
+
+_SEARCH_SIZE = 1024  # Same as qpdf, for both the header and startxref
+
+
+def _header_offset(stream: BinaryIO) -> int:
+    stream.seek(0)
+    return max(stream.read(_SEARCH_SIZE).find(b'%PDF-'), 0)
+
+
+def _last_xref(stream: BinaryIO, size: int, header_offset: int) -> tuple[int, bool]:
+    """Find the last cross-reference section of a PDF.
+
+    Returns its offset relative to the PDF header, and whether it is a
+    cross-reference stream rather than a table.
+    """
+    stream.seek(max(size - _SEARCH_SIZE, 0))
+    tail = stream.read()
+    pos = tail.rfind(b'startxref')
+    try:
+        if pos < 0:
+            raise ValueError
+        offset = int(tail[pos + len(b'startxref') :].split()[0])
+    except (IndexError, ValueError):
+        raise ValueError(
+            "The original PDF has no valid startxref, so an incremental update "
+            "cannot be appended to it. Save it normally instead."
+        ) from None
+    stream.seek(header_offset + offset)
+    return offset, stream.read(4) != b'xref'
+
+
+def _same_file(file1: Path, file2: Path) -> bool:
+    try:
+        return file1 == file2 or file1.samefile(file2)
+    except FileNotFoundError:
+        return False
+
+
+def save_incremental(
+    pdf: Pdf,
+    filename_or_stream: Path | str | BinaryIO,
+    *,
+    compress_streams: bool = True,
+) -> dict:
+    """Save *pdf* as its original bytes followed by an incremental update.
+
+    If the destination is the file or stream the Pdf was opened from, the update is
+    appended to it in place. Otherwise the original bytes are copied to the
+    destination first.
+
+    Returns statistics in the form of :attr:`Pdf.last_save_stats`.
+    """
+    if pdf.is_encrypted:
+        raise ValueError("incremental updates of encrypted PDFs are not supported")
+    original_filename = getattr(pdf, '_original_filename', None)
+    source = getattr(pdf, '_tmp_stream', None) or getattr(pdf, '_source_stream', None)
+
+    with ExitStack() as stack:
+        filename = None
+        if hasattr(filename_or_stream, 'seek'):
+            destination = filename_or_stream
+            in_place = source is not None and destination is source
+        else:
+            filename = Path(filename_or_stream)
+            in_place = original_filename is not None and _same_file(
+                original_filename, filename
+            )
+            destination = stack.enter_context(open(filename, 'r+b')) if in_place else None
+
+        # The update must describe the differences from the bytes it will be
+        # appended to, so when appending in place, compare with the destination
+        # even if the Pdf was read from an in-memory copy of it.
+        if in_place:
+            base = destination
+        elif hasattr(source, 'seek'):
+            base = source
+        elif source is not None:
+            base = BytesIO(source)  # Opened from a buffer
+        elif original_filename is not None:
+            base = stack.enter_context(open(original_filename, 'rb'))
+        else:
+            raise ValueError(
+                "incremental save requires a Pdf that was opened from a file or stream"
+            )
+
+        header_offset = _header_offset(base)
+        size = base.seek(0, os.SEEK_END)
+        prev, xref_stream = _last_xref(base, size, header_offset)
+        base.seek(0)
+        # Open the original the way the Pdf was opened, so that pages compare equal
+        # unless they were changed
+        inherit = getattr(pdf, '_inherit_page_attributes', True)
+        with Pdf.open(base, inherit_page_attributes=inherit) as original:
+            update, objects_written = pdf._incremental_update(
+                original,
+                offset=size - header_offset,
+                prev=prev,
+                xref_stream=xref_stream,
+                compress_streams=compress_streams,
+            )
+
+        if in_place:
+            destination.seek(size)
+            try:
+                destination.write(update)
+                destination.flush()
+            except BaseException:
+                destination.truncate(size)
+                raise
+        else:
+            if destination is None:
+                destination = stack.enter_context(atomic_overwrite(filename))
+            base.seek(0)
+            shutil.copyfileobj(base, destination)
+            destination.write(update)
+
+    return {
+        'bytes_written': len(update),
+        'objects_written': objects_written,
+        'incremental': True,
+    }
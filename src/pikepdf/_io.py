@@ -71,7 +71,9 @@ def atomic_overwrite(filename: Path) -> Generator[IO[bytes], None, None]:
         tf = NamedTemporaryFile(
             dir=filename.parent, prefix=f".pikepdf.{filename.name}", delete=False
         )
-        yield tf
+        # Yield the wrapped file object, so that Pdf.save can see that it is a plain
+        # file and write to its file descriptor directly
+        yield tf.file
         tf.flush()
         tf.close()
         with suppress(OSError):
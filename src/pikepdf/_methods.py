@@ -14,8 +14,10 @@ from __future__ import annotations
 
 import datetime
 import mimetypes
+import os
 import shutil
 from collections.abc import (
+    AsyncIterator,
     Callable,
     ItemsView,
     Iterator,
@@ -29,15 +31,18 @@ from io import BytesIO
 from pathlib import Path
 from subprocess import run
 from tempfile import TemporaryDirectory
-from typing import BinaryIO, Literal, TypeVar
+from typing import Any, BinaryIO, Literal, TypeVar
 from warnings import warn
 
+from pikepdf import _incremental, _streaming
+from pikepdf import xref_index as _xref_index
 from pikepdf._augments import augment_override_cpp, augments
 from pikepdf._core import (
     AccessMode,
     AttachedFile,
     AttachedFileSpec,
     Attachments,
+    CancellationToken,
     NameTree,
     NumberTree,
     ObjectStreamMode,
@@ -51,7 +56,14 @@ from pikepdf._core import (
     _ObjectMapping,
 )
 from pikepdf._io import atomic_overwrite, check_different_files, check_stream_is_usable
-from pikepdf.models import Encryption, EncryptionInfo, Outline, Permissions
+from pikepdf.models import (
+    CompressionPolicy,
+    Encryption,
+    EncryptionInfo,
+    Outline,
+    Permissions,
+    ProgressEvent,
+)
 from pikepdf.models.metadata import PdfMetadata, decode_pdf_date, encode_pdf_date
 from pikepdf.objects import Array, Dictionary, Name, Object, Stream
 
@@ -176,6 +188,19 @@ class Extend_Object:
 
         self._write(data, filter=filter, decode_parms=decode_parms)
 
+    def open_decoded(
+        self,
+        decode_level: StreamDecodeLevel = StreamDecodeLevel.generalized,
+        *,
+        chunk_size: int = 65536,
+        max_chunks: int = 16,
+    ) -> _streaming.DecodedStreamReader:
+        if not isinstance(self, Stream):
+            raise TypeError("open_decoded() requires a stream")
+        return _streaming.DecodedStreamReader(
+            self, decode_level, chunk_size, max_chunks
+        )
+
     def as_int(self, default: T = _MISSING) -> int | T:
         """Convert to int, or return default if not an integer.
 
@@ -378,8 +403,17 @@ class Extend_Pdf:
     def encryption(self) -> EncryptionInfo:
         return EncryptionInfo(self._encryption_data)
 
+    @property
+    def last_save_stats(self) -> dict[str, int] | None:
+        return getattr(self, '_last_save_stats', None)
+
     def check_pdf_syntax(
-        self, progress: Callable[[int], None] | None = None
+        self,
+        progress: Callable[[int], None] | None = None,
+        *,
+        progress_event: Callable[[ProgressEvent], None] | None = None,
+        cancellation_token: CancellationToken | None = None,
+        threads: int | None = None,
     ) -> list[str]:
         class DiscardingParser(StreamParser):
             def __init__(self):  # pylint: disable=useless-super-delegation
@@ -393,10 +427,26 @@ class Extend_Pdf:
 
         problems: list[str] = []
 
-        self._decode_all_streams_and_discard(progress)
+        if threads is None:
+            self._decode_all_streams_and_discard(
+                progress,
+                progress_event=progress_event,
+                cancellation_token=cancellation_token,
+            )
+        else:
+            for failure in self.validate_streams(
+                threads=threads, cancellation_token=cancellation_token
+            ):
+                objnum, gen = failure['objgen']
+                problems.append(
+                    f"ERROR: stream {objnum} {gen} R ({failure['filter']}): "
+                    f"{failure['error']}"
+                )
 
         discarding_parser = DiscardingParser()
         for page in self.pages:
+            if cancellation_token is not None:
+                cancellation_token.check()
             page.parse_contents(discarding_parser)
 
         for warning in self.get_warnings():
@@ -423,6 +473,11 @@ class Extend_Pdf:
         encryption: Encryption | bool | None = None,
         recompress_flate: bool = False,
         deterministic_id: bool = False,
+        compress_threads: int | None = None,
+        compression_policy: CompressionPolicy | None = None,
+        incremental: bool = False,
+        progress_event: Callable[[ProgressEvent], None] | None = None,
+        cancellation_token: CancellationToken | None = None,
     ) -> None:
         if not filename_or_stream and getattr(self, '_original_filename', None):
             filename_or_stream = self._original_filename
@@ -435,8 +490,40 @@ class Extend_Pdf:
                 "Pdf.new(), you must specify a destination object since there is "
                 "no original filename to save to."
             )
-        with ExitStack() as stack:
+        if incremental:
+            if linearize or qdf or normalize_content or encryption:
+                raise ValueError(
+                    "incremental save cannot be combined with linearize, qdf, "
+                    "normalize_content or encryption"
+                )
+            # The update is written by pikepdf rather than QPDFWriter, so options
+            # for the writer would be silently ignored
+            unsupported = {
+                'object_stream_mode': object_stream_mode != ObjectStreamMode.preserve,
+                'static_id': static_id,
+                'deterministic_id': deterministic_id,
+                'min_version': bool(min_version),
+                'force_version': bool(force_version),
+                'stream_decode_level': stream_decode_level is not None,
+                'recompress_flate': recompress_flate,
+                'progress': progress is not None,
+                'progress_event': progress_event is not None,
+                'cancellation_token': cancellation_token is not None,
+                'compress_threads': compress_threads is not None,
+                'compression_policy': compression_policy is not None,
+            }
+            if any(unsupported.values()):
+                names = ', '.join(name for name, used in unsupported.items() if used)
+                raise ValueError(f"incremental save does not support: {names}")
             if hasattr(filename_or_stream, 'seek'):
+                check_stream_is_usable(filename_or_stream)
+            self._last_save_stats = _incremental.save_incremental(
+                self, filename_or_stream, compress_streams=compress_streams
+            )
+            return
+        with ExitStack() as stack:
+            # Streams need not be seekable, so pipes and sockets can be written to
+            if hasattr(filename_or_stream, 'write'):
                 stream = filename_or_stream
                 check_stream_is_usable(filename_or_stream)
             else:
@@ -449,7 +536,7 @@ class Extend_Pdf:
                 ):
                     check_different_files(self._original_filename, filename)
                 stream = stack.enter_context(atomic_overwrite(filename))
-            self._save(
+            self._save_to_stream(
                 stream,
                 static_id=static_id,
                 preserve_pdfa=preserve_pdfa,
@@ -464,32 +551,61 @@ class Extend_Pdf:
                 qdf=qdf,
                 progress=progress,
                 encryption=encryption,
-                samefile_check=getattr(self, '_tmp_stream', None) is None,
                 recompress_flate=recompress_flate,
                 deterministic_id=deterministic_id,
+                compress_threads=compress_threads,
+                compression_policy=compression_policy,
+                progress_event=progress_event,
+                cancellation_token=cancellation_token,
             )
 
+    def _save_to_stream(self, stream: Any, **options: Any) -> None:
+        # Used by save() and iter_save(), which passes an _OutputChunkQueue
+        if options.pop('incremental', False):
+            raise ValueError("incremental save requires a file or stream")
+        self._last_save_stats = self._save(
+            stream,
+            samefile_check=getattr(self, '_tmp_stream', None) is None,
+            **options,
+        )
+
+    def iter_save(
+        self, *, chunk_size: int = 65536, max_chunks: int = 16, **save_options: Any
+    ) -> Iterator[bytes]:
+        return _streaming.iter_save(self, chunk_size, max_chunks, save_options)
+
+    def aiter_save(
+        self, *, chunk_size: int = 65536, max_chunks: int = 16, **save_options: Any
+    ) -> AsyncIterator[bytes]:
+        return _streaming.aiter_save(self, chunk_size, max_chunks, save_options)
+
     @staticmethod
     def open(
-        filename_or_stream: Path | str | BinaryIO,
+        filename_or_stream: Path | str | BinaryIO | bytearray | memoryview,
         *,
         password: str | bytes = "",
         hex_password: bool = False,
         ignore_xref_streams: bool = False,
         suppress_warnings: bool = True,
         attempt_recovery: bool = True,
-        inherit_page_attributes: bool = True,
+        inherit_page_attributes: bool | Literal['lazy'] = True,
         access_mode: AccessMode = AccessMode.default,
         allow_overwriting_input: bool = False,
+        xref_index: bool | str | os.PathLike = False,
     ) -> Pdf:
-        if isinstance(filename_or_stream, bytes) and filename_or_stream.startswith(
-            b'%PDF-'
+        lazy_page_attributes = inherit_page_attributes == 'lazy'
+        if isinstance(filename_or_stream, bytearray | memoryview):
+            access_mode = AccessMode.buffer
+        if (
+            isinstance(filename_or_stream, bytes)
+            and filename_or_stream.startswith(b'%PDF-')
+            and access_mode != AccessMode.buffer
         ):
             warn(
                 "It looks like you called with Pdf.open(data) with a bytes-like object "
                 "containing a PDF. This will probably fail because this function "
                 "expects a filename or opened file-like object. Instead, please use "
-                "Pdf.open(BytesIO(data))."
+                "Pdf.open(data, access_mode=AccessMode.buffer)."
             )
         if isinstance(filename_or_stream, int | float):
             # Attempted to open with integer file descriptor?
@@ -500,7 +616,24 @@ class Extend_Pdf:
         closing_stream: bool = False
         original_filename: Path | None = None
 
-        if allow_overwriting_input:
+        xref_index_data, xref_index_key = b'', None
+        if xref_index and not ignore_xref_streams:
+            if not isinstance(filename_or_stream, str | os.PathLike):
+                raise ValueError('"xref_index" requires a file path')
+            xref_index_path = None if xref_index is True else xref_index
+            xref_index_data, xref_index_key = _xref_index._load_for_open(
+                filename_or_stream, xref_index_path
+            )
+
+        if access_mode == AccessMode.buffer:
+            if allow_overwriting_input:
+                raise ValueError(
+                    '"allow_overwriting_input=True" cannot be used with '
+                    'AccessMode.buffer'
+                )
+            stream = filename_or_stream
+            description = f"memory buffer {type(filename_or_stream).__name__}"
+        elif allow_overwriting_input:
             try:
                 Path(filename_or_stream)
             except TypeError as error:
@@ -527,7 +660,8 @@ class Extend_Pdf:
             closing_stream = True
 
         try:
-            check_stream_is_usable(stream)
+            if access_mode != AccessMode.buffer:
+                check_stream_is_usable(stream)
             pdf = Pdf._open(
                 stream,
                 password=password,
@@ -535,17 +669,29 @@ class Extend_Pdf:
                 ignore_xref_streams=ignore_xref_streams,
                 suppress_warnings=suppress_warnings,
                 attempt_recovery=attempt_recovery,
-                inherit_page_attributes=inherit_page_attributes,
+                inherit_page_attributes=(
+                    bool(inherit_page_attributes) and not lazy_page_attributes
+                ),
+                lazy_page_attributes=lazy_page_attributes,
                 access_mode=access_mode,
                 description=description,
                 closing_stream=closing_stream,
+                xref_index=xref_index_data,
             )
         except Exception:
             if stream is not None and closing_stream:
                 stream.close()
             raise
         pdf._tmp_stream = stream if allow_overwriting_input else None
+        pdf._source_stream = (
+            stream if not closing_stream and not allow_overwriting_input else None
+        )
         pdf._original_filename = original_filename
+        pdf._inherit_page_attributes = inherit_page_attributes
+        if xref_index_key is not None and not xref_index_data:
+            _xref_index._save_after_open(
+                pdf, filename_or_stream, xref_index_path, xref_index_key
+            )
         return pdf
 
 
@@ -585,9 +731,12 @@ def check_is_box(obj) -> None:
 
 @augments(Page)
 class Extend_Page:
+    # With lazy page attributes, reading a box that the page inherits must not copy
+    # it to the page, so boxes are only copied otherwise
+
     @property
     def mediabox(self):
-        return self._get_mediabox(True)
+        return self._get_mediabox(not self._lazy_inheritance)
 
     @mediabox.setter
     def mediabox(self, value):
@@ -596,7 +745,7 @@ class Extend_Page:
 
     @property
     def artbox(self):
-        return self._get_artbox(True, False)
+        return self._get_artbox(not self._lazy_inheritance, False)
 
     @artbox.setter
     def artbox(self, value):
@@ -605,7 +754,7 @@ class Extend_Page:
 
     @property
     def bleedbox(self):
-        return self._get_bleedbox(True, False)
+        return self._get_bleedbox(not self._lazy_inheritance, False)
 
     @bleedbox.setter
     def bleedbox(self, value):
@@ -614,7 +763,7 @@ class Extend_Page:
 
     @property
     def cropbox(self):
-        return self._get_cropbox(True, False)
+        return self._get_cropbox(not self._lazy_inheritance, False)
 
     @cropbox.setter
     def cropbox(self, value):
@@ -623,7 +772,7 @@ class Extend_Page:
 
     @property
     def trimbox(self):
-        return self._get_trimbox(True, False)
+        return self._get_trimbox(not self._lazy_inheritance, False)
 
     @trimbox.setter
     def trimbox(self, value):
@@ -641,7 +790,12 @@ class Extend_Page:
     @property
     def resources(self) -> Dictionary:
         if Name.Resources not in self.obj:
-            self.obj.Resources = Dictionary()
+            # With lazy page attributes, use any resources the page inherits, as if
+            # they had been pushed to the pages when the Pdf was opened
+            inherited = self._lazy_inherited_attribute('/Resources', copy=True)
+            self.obj.Resources = (
+                inherited if isinstance(inherited, Dictionary) else Dictionary()
+            )
         elif not isinstance(self.obj.Resources, Dictionary):
             raise TypeError("Page /Resources exists but is not a dictionary")
         return self.obj.Resources
@@ -752,7 +906,13 @@ class Extend_Page:
         return self._contents_add(contents, prepend=prepend)
 
     def __getattr__(self, name):
-        return getattr(self.obj, name)
+        try:
+            return getattr(self.obj, name)
+        except AttributeError:
+            inherited = self._lazy_inherited_attribute('/' + name)
+            if inherited is None:
+                raise
+            return inherited
 
     @augment_override_cpp
     def __setattr__(self, name, value):
@@ -769,7 +929,13 @@ class Extend_Page:
             delattr(self.obj, name)
 
     def __getitem__(self, key):
-        return self.obj[key]
+        try:
+            return self.obj[key]
+        except KeyError:
+            inherited = self._lazy_inherited_attribute(str(key))
+            if inherited is None:
+                raise
+            return inherited
 
     def __setitem__(self, key, value):
         self.obj[key] = value
@@ -778,7 +944,9 @@ class Extend_Page:
         del self.obj[key]
 
     def __contains__(self, key):
-        return key in self.obj
+        return (
+            key in self.obj or self._lazy_inherited_attribute(str(key)) is not None
+        )
 
     def get(self, key, default=None):
         try:
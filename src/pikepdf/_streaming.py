@@ -0,0 +1,157 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Stream PDF output and decoded stream data in chunks of bounded size.
+
+Saving a PDF, or decoding one of its streams, runs on a background thread and
+hands its output to the consumer through a bounded queue. When the queue is full
+the producer waits for the consumer, so memory use depends on the chunk size and
+queue length, not on the size of the output.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import io
+import threading
+from collections.abc import AsyncIterator, Callable, Iterator
+from typing import Any
+
+from pikepdf._core import Object, Pdf, StreamDecodeLevel, _OutputChunkQueue
+
+
+class _BackgroundSave:
+    def __init__(self, pdf: Pdf, chunk_size: int, max_chunks: int, options: dict):
+        self.queue = _OutputChunkQueue(chunk_size, max_chunks)
+        self.error: BaseException | None = None
+        self.thread = threading.Thread(
+            target=self._run, args=(pdf, options), name='pikepdf save', daemon=True
+        )
+
+    def _run(self, pdf: Pdf, options: dict[str, Any]) -> None:
+        try:
+            # Writes without the GIL; until the save finishes, other threads that
+            # try to use the Pdf get a RuntimeError
+            pdf._save_to_stream(self.queue, **options)
+        except BaseException as e:  # pylint: disable=broad-except
+            self.error = e
+        finally:
+            self.queue.close()
+
+    def raise_error(self) -> None:
+        if self.error is not None:
+            raise self.error
+
+
+def iter_save(
+    pdf: Pdf, chunk_size: int, max_chunks: int, options: dict[str, Any]
+) -> Iterator[bytes]:
+    save = _BackgroundSave(pdf, chunk_size, max_chunks, options)
+
+    def chunks() -> Iterator[bytes]:
+        save.thread.start()
+        try:
+            while (chunk := save.queue.get()) is not None:
+                yield chunk
+        finally:
+            # If the consumer stopped early, this aborts the save
+            save.queue.cancel()
+            save.thread.join()
+        save.raise_error()
+
+    return chunks()
+
+
+def aiter_save(
+    pdf: Pdf, chunk_size: int, max_chunks: int, options: dict[str, Any]
+) -> AsyncIterator[bytes]:
+    save = _BackgroundSave(pdf, chunk_size, max_chunks, options)
+
+    async def chunks() -> AsyncIterator[bytes]:
+        save.thread.start()
+        try:
+            while (chunk := await asyncio.to_thread(save.queue.get)) is not None:
+                yield chunk
+        finally:
+            # Even if this task was cancelled while waiting for a chunk, cancelling
+            # the queue ends the save, which closes the queue and ends the wait
+            save.queue.cancel()
+            await asyncio.to_thread(save.thread.join)
+        save.raise_error()
+
+    return chunks()
+
+
+class DecodedStreamReader(io.RawIOBase):
+    """A read-only file-like view of a stream's decoded data.
+
+    Returned by :meth:`pikepdf.Object.open_decoded`.
+    """
+
+    def __init__(
+        self,
+        obj: Object,
+        decode_level: StreamDecodeLevel,
+        chunk_size: int,
+        max_chunks: int,
+    ):
+        super().__init__()
+        self._queue = _OutputChunkQueue(chunk_size, max_chunks)
+        self._error: BaseException | None = None
+        self._pending = memoryview(b'')
+        self._eof = False
+        self._thread: threading.Thread | None = None
+        # The Pdf is not thread-safe, so its raw data is read here, and only that
+        # copy is decoded on the background thread
+        decoder = obj._detach_decoder(decode_level)
+        if decoder is None:
+            # Its decoder needs the Pdf or Python, so decode it all here instead
+            self._pending = memoryview(obj.read_bytes(decode_level))
+            self._eof = True
+            self._queue.close()
+            return
+        self._thread = threading.Thread(
+            target=self._run, args=(decoder,), name='pikepdf decode', daemon=True
+        )
+        self._thread.start()
+
+    def _run(self, decoder: Callable[[_OutputChunkQueue], None]) -> None:
+        try:
+            # Releases the GIL while decoding
+            decoder(self._queue)
+        except BaseException as e:  # pylint: disable=broad-except
+            self._error = e
+        finally:
+            self._queue.close()
+
+    def readable(self) -> bool:
+        return True
+
+    def readinto(self, buffer) -> int:
+        if self.closed:
+            raise ValueError("I/O operation on closed file.")
+        while not self._pending and not self._eof:
+            chunk = self._queue.get()
+            if chunk is None:
+                self._eof = True
+                if self._thread is not None:
+                    self._thread.join()
+                if self._error is not None:
+                    error, self._error = self._error, None
+                    raise error
+            else:
+                self._pending = memoryview(chunk)
+        target = memoryview(buffer).cast('B')
+        n = min(len(target), len(self._pending))
+        target[:n] = self._pending[:n]
+        self._pending = self._pending[n:]
+        return n
+
+    def close(self) -> None:
+        if not self.closed:
+            # If decoding has not finished, this aborts it
+            self._queue.cancel()
+            if self._thread is not None:
+                self._thread.join()
+            self._pending = memoryview(b'')
+        super().close()
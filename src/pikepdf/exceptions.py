@@ -9,6 +9,7 @@ from pikepdf._core import (
     DataDecodingError,
     DeletedObjectError,
     ForeignObjectError,
+    OperationCancelledError,
     PasswordError,
     PdfError,
 )
@@ -30,6 +31,7 @@ __all__ = [
     'HifiPrintImageNotTranscodableError',
     'ImageDecompressionError',
     'InvalidPdfImageError',
+    'OperationCancelledError',
     'OutlineStructureError',
     'PasswordError',
     'PdfError',
@@ -3,8 +3,8 @@
 
 """Integrate JBIG2 image decoding.
 
-Requires third-party JBIG2 decoder in the form of an external program, like
-jbig2dec.
+Requires third-party JBIG2 decoder, either libjbig2dec linked into pikepdf at
+build time, or an external program, like jbig2dec.
 """
 
 from __future__ import annotations
@@ -19,6 +19,7 @@ from tempfile import TemporaryDirectory
 from packaging.version import InvalidVersion, Version
 from PIL import Image
 
+from pikepdf import _core
 from pikepdf._exceptions import DependencyError
 
 if sys.platform == 'win32':
@@ -120,7 +121,32 @@ class JBIG2Decoder(JBIG2DecoderInterface):
                 return None
 
 
-_jbig2_decoder: JBIG2DecoderInterface = JBIG2Decoder()
+class NativeJBIG2Decoder(JBIG2DecoderInterface):
+    """JBIG2 decoder using libjbig2dec, linked into pikepdf.
+
+    Available when pikepdf is built with ``PIKEPDF_WITH_JBIG2DEC=1``. While it
+    is the selected decoder, JBIG2 streams are decoded in pikepdf's C++ code,
+    without the GIL or a subprocess, and so can also be decoded on worker
+    threads.
+
+    .. versionadded:: 10.3
+    """
+
+    def check_available(self) -> None:
+        """Check if pikepdf was built with libjbig2dec."""
+        if not _core._jbig2dec_native_available():
+            raise DependencyError("pikepdf was not built with libjbig2dec")
+
+    def decode_jbig2(self, jbig2: bytes, jbig2_globals: bytes) -> bytes:
+        """Decode JBIG2 from binary data, returning decode bytes."""
+        self.check_available()
+        return _core._jbig2dec_decode(jbig2, jbig2_globals)
+
+
+_jbig2_decoder: JBIG2DecoderInterface = (
+    NativeJBIG2Decoder() if _core._jbig2dec_native_available() else JBIG2Decoder()
+)
+_core._set_jbig2_native_decoding(isinstance(_jbig2_decoder, NativeJBIG2Decoder))
 
 
 def get_decoder() -> JBIG2DecoderInterface:
@@ -129,6 +155,43 @@ def get_decoder() -> JBIG2DecoderInterface:
 
 
 def set_decoder(jbig2_decoder: JBIG2DecoderInterface) -> None:
-    """Set the JBIG2 decoder to use."""
+    """Set the JBIG2 decoder to use.
+
+    If pikepdf was built with libjbig2dec, :class:`NativeJBIG2Decoder` is the
+    default; otherwise :class:`JBIG2Decoder`, which runs the jbig2dec program.
+    """
     global _jbig2_decoder
+    native = isinstance(jbig2_decoder, NativeJBIG2Decoder)
+    if native:
+        jbig2_decoder.check_available()
+    _core._set_jbig2_native_decoding(native)
     _jbig2_decoder = jbig2_decoder
+
+
+def get_globals_cache_stats() -> dict[str, int]:
+    """Return counters for pikepdf's caches of JBIG2 global segments.
+
+    Images in a PDF often share one ``/JBIG2Globals`` stream. pikepdf caches the
+    decoded data of each such stream, keyed by the :class:`pikepdf.Pdf` and
+    object, and :class:`NativeJBIG2Decoder` also caches the parsed symbol
+    dictionaries, so that each image does not parse them again.
+
+    Returns:
+        A dictionary with ``data_hits`` and ``data_misses`` for lookups of
+        ``/JBIG2Globals`` stream data, and ``parse_hits`` and ``parse_misses``
+        for lookups of parsed globals by the native decoder.
+
+    .. versionadded:: 10.3
+    """
+    return _core._jbig2_cache_stats()
+
+
+def clear_globals_cache() -> None:
+    """Empty the JBIG2 global segment caches and reset their counters.
+
+    Parsed globals are cached per thread, so only those of the calling thread
+    are removed.
+
+    .. versionadded:: 10.3
+    """
+    _core._jbig2_cache_clear()
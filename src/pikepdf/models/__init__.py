@@ -12,7 +12,9 @@ from pikepdf.models._content_stream import (
     parse_content_stream,
     unparse_content_stream,
 )
+from pikepdf.models.compression import CompressionPolicy
 from pikepdf.models.encryption import Encryption, EncryptionInfo, Permissions
+from pikepdf.models.extraction import ExtractedImage, extract_all_images
 from pikepdf.models.image import (
     PdfImage,
     PdfInlineImage,
@@ -26,6 +28,7 @@ from pikepdf.models.outlines import (
     PageLocation,
     make_page_destination,
 )
+from pikepdf.models.progress import ProgressEvent
 
 __all__ = [
     'ContentStreamInstructions',
@@ -33,9 +36,12 @@ __all__ = [
     'UnparseableContentStreamInstructions',
     'parse_content_stream',
     'unparse_content_stream',
+    'CompressionPolicy',
     'Encryption',
     'EncryptionInfo',
     'Permissions',
+    'ExtractedImage',
+    'extract_all_images',
     'PdfImage',
     'PdfInlineImage',
     'UnsupportedImageTypeError',  # legacy
@@ -46,4 +52,5 @@ __all__ = [
     'OutlineStructureError',  # legacy
     'PageLocation',
     'make_page_destination',
+    'ProgressEvent',
 ]
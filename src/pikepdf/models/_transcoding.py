@@ -10,13 +10,14 @@ from typing import Any, NamedTuple
 from PIL import Image
 from PIL.TiffTags import TAGS_V2 as TIFF_TAGS
 
+from pikepdf import _core
+
 
 class ImageDecompressionError(Exception):
     """Image decompression error."""
 
 
 BytesLike = bytes | memoryview
-MutableBytesLike = bytearray | memoryview
 
 
 def _next_multiple(n: int, k: int) -> int:
@@ -34,7 +35,12 @@ def _next_multiple(n: int, k: int) -> int:
 
 
 def unpack_subbyte_pixels(
-    packed: BytesLike, size: tuple[int, int], bits: int, scale: int = 0
+    packed: BytesLike,
+    size: tuple[int, int],
+    bits: int,
+    scale: int = 0,
+    *,
+    invert: bool = False,
 ) -> tuple[BytesLike, int]:
     """Unpack subbyte *bits* pixels into full bytes and rescale.
 
@@ -46,69 +52,25 @@ def unpack_subbyte_pixels(
         0b11 = 1.00 = 0xff
     When scale is 1, no scaling is applied, appropriate when
     the bytes are palette indexes.
+
+    When invert is True, each sample is inverted before it is scaled, as a
+    /Decode array of [1 0] requires.
+
+    The work is done by a native kernel, which uses SIMD instructions where
+    available, and releases the GIL.
     """
+    if bits not in (1, 2, 4):
+        raise NotImplementedError(bits)
     width, height = size
     bits_per_byte = 8 // bits
     stride = _next_multiple(width, bits_per_byte)
     buffer = bytearray(bits_per_byte * stride * height)
-    max_read = len(buffer) // bits_per_byte
     if scale == 0:
         scale = 255 / ((2**bits) - 1)
-    if bits == 4:
-        _4bit_inner_loop(packed[:max_read], buffer, scale)
-    elif bits == 2:
-        _2bit_inner_loop(packed[:max_read], buffer, scale)
-    # elif bits == 1:
-    #     _1bit_inner_loop(packed[:max_read], buffer, scale)
-    else:
-        raise NotImplementedError(bits)
+    _core._unpack_subbyte_pixels(packed, buffer, bits, scale, invert)
     return memoryview(buffer), stride
 
 
-# def _1bit_inner_loop(in_: BytesLike, out: MutableBytesLike, scale: int) -> None:
-#     """Unpack 1-bit values to their 8-bit equivalents.
-
-#     Thus *out* must be 8x at long as *in*.
-#     """
-#     for n, val in enumerate(in_):
-#         out[8 * n + 0] = int((val >> 7) & 0b1) * scale
-#         out[8 * n + 1] = int((val >> 6) & 0b1) * scale
-#         out[8 * n + 2] = int((val >> 5) & 0b1) * scale
-#         out[8 * n + 3] = int((val >> 4) & 0b1) * scale
-#         out[8 * n + 4] = int((val >> 3) & 0b1) * scale
-#         out[8 * n + 5] = int((val >> 2) & 0b1) * scale
-#         out[8 * n + 6] = int((val >> 1) & 0b1) * scale
-#         out[8 * n + 7] = int((val >> 0) & 0b1) * scale
-
-
-def _2bit_inner_loop(in_: BytesLike, out: MutableBytesLike, scale: int) -> None:
-    """Unpack 2-bit values to their 8-bit equivalents.
-
-    Thus *out* must be 4x at long as *in*.
-
-    Images of this type are quite rare in practice, so we don't
-    optimize this loop.
-    """
-    for n, val in enumerate(in_):
-        out[4 * n] = int((val >> 6) * scale)
-        out[4 * n + 1] = int(((val >> 4) & 0b11) * scale)
-        out[4 * n + 2] = int(((val >> 2) & 0b11) * scale)
-        out[4 * n + 3] = int((val & 0b11) * scale)
-
-
-def _4bit_inner_loop(in_: BytesLike, out: MutableBytesLike, scale: int) -> None:
-    """Unpack 4-bit values to their 8-bit equivalents.
-
-    Thus *out* must be 2x at long as *in*.
-
-    Images of this type are quite rare in practice, so we don't
-    optimize this loop.
-    """
-    for n, val in enumerate(in_):
-        out[2 * n] = int((val >> 4) * scale)
-        out[2 * n + 1] = int((val & 0b1111) * scale)
-
-
 def image_from_byte_buffer(buffer: BytesLike, size: tuple[int, int], stride: int):
     """Use Pillow to create one-component image from a byte buffer.
 
@@ -136,20 +98,43 @@ def image_from_byte_buffer(buffer: BytesLike, size: tuple[int, int], stride: int
 
 
 def _make_rgb_palette(gray_palette: bytes) -> bytes:
-    palette = b''
-    for entry in gray_palette:
-        palette += bytes([entry]) * 3
-    return palette
+    return bytes(value for entry in gray_palette for value in (entry, entry, entry))
 
 
 def _depalettize_cmyk(buffer: BytesLike, palette: BytesLike):
     with memoryview(buffer) as mv:
-        output = bytearray(4 * len(mv))
-        for n, pal_idx in enumerate(mv):
-            output[4 * n : 4 * (n + 1)] = palette[4 * pal_idx : 4 * (pal_idx + 1)]
+        output = bytearray(4 * mv.nbytes)
+        _core._expand_palette(mv, output, mv.nbytes, 1, 8, palette, 4)
     return output
 
 
+def expand_palette(
+    packed: BytesLike,
+    size: tuple[int, int],
+    bits: int,
+    palette: BytesLike,
+    components: int,
+    out: Any = None,
+) -> Any:
+    """Look up every index of an Indexed image in its palette.
+
+    *packed* holds the image's indexes, of *bits* each, with every row starting
+    on a byte boundary. Each palette entry is *components* bytes. The colors
+    are written in rows of ``width * components`` bytes with no padding, to
+    *out* if given, which may be any writable buffer such as a ``bytearray``,
+    ``memoryview`` or numpy array, or else to a new ``bytearray``. Returns the
+    buffer written to.
+
+    Indexes past the end of the palette use its last entry. The work is done by a
+    native kernel in one pass, and releases the GIL.
+    """
+    width, height = size
+    if out is None:
+        out = bytearray(width * height * components)
+    _core._expand_palette(packed, out, width, height, bits, palette, components)
+    return out
+
+
 def image_from_buffer_and_palette(
     buffer: BytesLike,
     size: tuple[int, int],
@@ -174,7 +159,9 @@ def image_from_buffer_and_palette(
     elif base_mode == 'CMYK':
         # Pillow does not support CMYK with palettes; convert manually
         output = _depalettize_cmyk(buffer, palette)
-        im = Image.frombuffer('CMYK', size, data=output, decoder_name='raw')
+        im = Image.frombuffer(
+            'CMYK', size, output, 'raw', 'CMYK', 4 * (stride or size[0]), 1
+        )
     else:
         raise NotImplementedError(f'palette with {base_mode}')
     return im
@@ -0,0 +1,51 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Specify how stream data is compressed when a PDF is saved."""
+
+from __future__ import annotations
+
+from typing import NamedTuple
+
+
+class CompressionPolicy(NamedTuple):
+    """Choose whether and how hard to compress each stream when a PDF is saved.
+
+    Pass to :meth:`pikepdf.Pdf.save` as ``compression_policy``. Each stream that
+    would be compressed during the save is sampled first. If compressing it is not
+    expected to save at least ``min_gain`` of its size, it is written uncompressed;
+    otherwise it is compressed at a level chosen by its class and size. The
+    decisions are reported in :attr:`pikepdf.Pdf.last_save_stats`.
+
+    Compression levels are zlib levels from 0 to 9, or -1 for the level set with
+    :func:`pikepdf.settings.set_flate_compression_level`.
+    """
+
+    min_gain: float = 0.05
+    """Minimum estimated fraction of a stream's size that compression must save.
+    The estimate is based on the byte entropy of a sample of the stream, and is
+    conservative for text-like data such as content streams. Data that is already
+    compressed or encrypted is estimated to save almost nothing."""
+
+    sample_size: int = 16384
+    """Number of bytes of each stream to sample, from several places in the
+    stream. 0 samples the whole stream."""
+
+    content_level: int = -1
+    """Level for content streams of pages and form XObjects."""
+
+    font_level: int = 9
+    """Level for embedded font programs, which are usually small and read often."""
+
+    image_level: int = 1
+    """Level for image XObjects, which are usually large and compress poorly."""
+
+    other_level: int = -1
+    """Level for all other streams."""
+
+    large_stream_size: int = 4 * 1024 * 1024
+    """Streams whose stored size is at least this many bytes are compressed at
+    ``large_stream_level``, whatever their class."""
+
+    large_stream_level: int = 1
+    """Level for large streams."""
@@ -0,0 +1,221 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Extract all of the images in a PDF at once."""
+
+from __future__ import annotations
+
+import os
+from collections import deque
+from collections.abc import Callable
+from concurrent.futures import Future, ThreadPoolExecutor
+from functools import partial
+from io import BytesIO
+from pathlib import Path
+from typing import NamedTuple
+
+from pikepdf._core import ContentStreamInlineImage, Pdf, PdfError, StreamDecodeLevel
+from pikepdf.models._content_stream import parse_content_stream
+from pikepdf.models.image import (
+    PdfImage,
+    UnsupportedImageTypeError,
+    _save_transcoded,
+    _transcoded_extension,
+)
+
+# Images with these filters are usually copied to a file without decoding them
+_PASSTHROUGH_FILTERS = {'/DCTDecode', '/JPXDecode', '/CCITTFaxDecode'}
+
+
+class ExtractedImage(NamedTuple):
+    """An image found by :func:`extract_all_images`, and the file written for it.
+
+    ``objgen`` is the object and generation number of the image XObject, or
+    ``None`` for an inline image. ``name`` is its name in the page's resources,
+    such as ``"/Im0"``, or ``""`` for an inline image.
+
+    ``page`` is the index of the first page that uses the image, and ``pages``
+    the indexes of every page that does.
+
+    ``path`` is the file that was written, or ``None`` if the image could not be
+    extracted, in which case ``error`` says why.
+    """
+
+    objgen: tuple[int, int] | None
+    name: str
+    page: int
+    pages: tuple[int, ...]
+    path: Path | None
+    error: str | None
+
+
+def _error_text(e: BaseException) -> str:
+    return f"{type(e).__name__}: {e}"
+
+
+def _prepare(image: PdfImage, prefix: Path) -> tuple[Path, Callable[[], object]]:
+    """Do the part of extracting an image that needs its PDF.
+
+    Returns the path to write, and a function that writes it and is safe to run
+    on another thread.
+    """
+    bio = BytesIO()
+    extension = image._extract_direct(stream=bio)
+    if extension:
+        path = prefix.with_name(prefix.name + extension)
+        return path, partial(path.write_bytes, bio.getvalue())
+
+    im = image._extract_transcoded()
+    if not im:
+        raise UnsupportedImageTypeError(repr(image))
+    path = prefix.with_name(prefix.name + _transcoded_extension(im))
+
+    def write():
+        try:
+            with path.open('wb') as f:
+                _save_transcoded(im, f)
+        finally:
+            im.close()
+
+    return path, write
+
+
+def extract_all_images(
+    pdf: Pdf,
+    out_dir: Path | str,
+    *,
+    workers: int = 0,
+    inline_images: bool = True,
+) -> list[ExtractedImage]:
+    """Extract every image in a PDF to files in a directory.
+
+    Image XObjects used by the pages, including those inside Form XObjects, are
+    found in one pass, and each is extracted once however many pages use it. The
+    images that must be decoded are decoded on a pool of worker threads with
+    the GIL released, as :meth:`pikepdf.Pdf.read_streams` does, and converted
+    images are compressed and written on a pool of threads while Pillow releases
+    the GIL.
+
+    Each image is written as :meth:`pikepdf.PdfImage.extract_to` would write it:
+    JPEG, JPEG 2000 and CCITT images are copied without transcoding as ``.jpg``,
+    ``.jp2`` and ``.tif`` files, and other images are converted to ``.png``, or
+    ``.tiff`` for CMYK. Files for image XObjects are named
+    ``image-{obj}-{gen}``, and for inline images ``page-{page}-inline-{n}``.
+
+    An image that cannot be extracted does not stop the others; its entry in
+    the result has an error instead of a path.
+
+    Args:
+        pdf: The PDF to extract images from.
+        out_dir: The directory to write the images to, which is created if
+            necessary.
+        workers: Number of worker threads. 0 uses one per CPU.
+        inline_images: Whether to extract inline images from the pages' content
+            streams. Inline images inside Form XObjects are not extracted.
+
+    Returns:
+        One entry per image, image XObjects first, in the order the pages use
+        them.
+
+    .. versionadded:: 10.3
+    """
+    out_dir = Path(out_dir)
+    out_dir.mkdir(parents=True, exist_ok=True)
+    if workers <= 0:
+        workers = os.cpu_count() or 1
+
+    # objgen, name, pages, and either the path being written and its write, or
+    # an error
+    rows: list[
+        tuple[tuple[int, int] | None, str, tuple[int, ...], Path | None, Future | str]
+    ] = []
+
+    with ThreadPoolExecutor(max_workers=workers) as executor:
+        pending: deque[Future] = deque()
+
+        def extract(image, prefix, objgen, name, pages):
+            try:
+                path, write = _prepare(image, prefix)
+            except Exception as e:
+                rows.append((objgen, name, pages, None, _error_text(e)))
+                return
+            future = executor.submit(write)
+            rows.append((objgen, name, pages, path, future))
+            # Bound the memory held by images waiting to be written
+            pending.append(future)
+            while len(pending) > 2 * workers:
+                pending.popleft().exception()
+
+        found = pdf._collect_images()
+        batch_size = 4 * workers
+        for start in range(0, len(found), batch_size):
+            batch = found[start : start + batch_size]
+            images: list[PdfImage | Exception] = []
+            for obj, _name, _pages in batch:
+                try:
+                    images.append(PdfImage(obj))
+                except Exception as e:
+                    images.append(e)
+
+            to_decode = [
+                image
+                for image in images
+                if isinstance(image, PdfImage)
+                and not _PASSTHROUGH_FILTERS.intersection(image.filters)
+            ]
+            decoded = pdf.read_streams(
+                [image.obj for image in to_decode],
+                decode_level=StreamDecodeLevel.specialized,
+                threads=workers,
+            )
+            for image, data in zip(to_decode, decoded):
+                # Images that failed to decode report their error when extracted
+                if isinstance(data, bytes):
+                    image._decoded = data
+
+            for (obj, name, pages), image in zip(batch, images):
+                objgen = obj.objgen
+                pages = tuple(pages)
+                if isinstance(image, Exception):
+                    rows.append((objgen, name, pages, None, _error_text(image)))
+                    continue
+                prefix = out_dir / f'image-{objgen[0]}-{objgen[1]}'
+                extract(image, prefix, objgen, name, pages)
+
+        if inline_images:
+            for n, page in enumerate(pdf.pages):
+                try:
+                    instructions = parse_content_stream(page, 'BI ID EI')
+                except PdfError as e:
+                    rows.append((None, '', (n,), None, _error_text(e)))
+                    continue
+                inline = (
+                    inst.iimage
+                    for inst in instructions
+                    if isinstance(inst, ContentStreamInlineImage)
+                )
+                for k, iimage in enumerate(inline):
+                    prefix = out_dir / f'page-{n}-inline-{k}'
+                    try:
+                        image = iimage._convert_to_pdfimage()
+                    except Exception as e:
+                        rows.append((None, '', (n,), None, _error_text(e)))
+                        continue
+                    extract(image, prefix, None, '', (n,))
+
+    manifest = []
+    for objgen, name, pages, path, outcome in rows:
+        if isinstance(outcome, Future):
+            exc = outcome.exception()
+            error = _error_text(exc) if exc else None
+        else:
+            error = outcome
+        manifest.append(
+            ExtractedImage(
+                objgen, name, pages[0], pages, path if error is None else None, error
+            )
+        )
+    return manifest
+
+
+__all__ = ['ExtractedImage', 'extract_all_images']
@@ -99,6 +99,18 @@ def _metadata_from_obj(
     raise NotImplementedError('Metadata access for ' + name)
 
 
+def _transcoded_extension(im: Image.Image) -> str:
+    return '.tiff' if im.mode == 'CMYK' else '.png'
+
+
+def _save_transcoded(im: Image.Image, stream: BinaryIO) -> None:
+    """Save a transcoded image in the format named by _transcoded_extension."""
+    if im.mode == 'CMYK':
+        im.save(stream, format='tiff', compression='tiff_adobe_deflate')
+    else:
+        im.save(stream, format='png')
+
+
 class PaletteData(NamedTuple):
     """Returns the color space and binary representation of the palette.
 
@@ -375,6 +387,8 @@ class PdfImage(PdfImageBase):
     obj: Stream
     _icc: ImageCmsProfile | None
     _pdf_source: Pdf | None
+    # Data decoded in advance by extract_all_images, used in place of read_bytes
+    _decoded: bytes | None = None
 
     def __new__(cls, obj: Stream):
         """Construct a PdfImage... or a PdfJpxImage if that is what we really are."""
@@ -483,7 +497,7 @@ class PdfImage(PdfImageBase):
             )
         if len(indices) == 0:
             # No complex filter indices, so all filters are simple - remove them all
-            return self.obj.read_bytes(StreamDecodeLevel.specialized), []
+            return self.read_bytes(StreamDecodeLevel.specialized), []
 
         n = indices[0]
         if n == 0:
@@ -553,6 +567,9 @@ class PdfImage(PdfImageBase):
 
     def _extract_transcoded_1248bits(self) -> Image.Image:
         """Extract an image when there are 1/2/4/8 bits packed in byte data."""
+        if self._has_cmyk_palette():
+            return self._extract_depalettized_cmyk(self.read_bytes())
+
         stride = 0  # tell Pillow to calculate stride from line width
         scale = 0 if self.mode == 'L' else 1
         if self.bits_per_component in (2, 4):
@@ -577,6 +594,18 @@ class PdfImage(PdfImageBase):
             im = _transcoding.image_from_byte_buffer(buffer, self.size, stride)
         return im
 
+    def _has_cmyk_palette(self) -> bool:
+        palette = self.palette
+        return palette is not None and palette.base_colorspace == 'CMYK'
+
+    def _extract_depalettized_cmyk(self, data: bytes) -> Image.Image:
+        # Pillow does not support CMYK palettes, so look up the colors ourselves
+        palette = cast(PaletteData, self.palette)
+        buffer = _transcoding.expand_palette(
+            data, self.size, self.bits_per_component, palette.palette, 4
+        )
+        return Image.frombuffer('CMYK', self.size, buffer, 'raw', 'CMYK', 0, 1)
+
     def _extract_transcoded_1bit(self) -> Image.Image:
         if not self.image_mask and self.mode in ('RGB', 'CMYK'):
             raise UnsupportedImageTypeError("1-bit RGB and CMYK are not supported")
@@ -593,6 +622,9 @@ class PdfImage(PdfImageBase):
                 ) from None
             raise
 
+        if self._has_cmyk_palette():
+            return self._extract_depalettized_cmyk(data)
+
         im = Image.frombytes('1', self.size, data)
 
         if self.palette is not None:
@@ -655,12 +687,9 @@ class PdfImage(PdfImageBase):
         im = None
         try:
             im = self._extract_transcoded()
-            if im.mode == 'CMYK':
-                im.save(stream, format='tiff', compression='tiff_adobe_deflate')
-                return '.tiff'
             if im:
-                im.save(stream, format='png')
-                return '.png'
+                _save_transcoded(im, stream)
+                return _transcoded_extension(im)
         except PdfError as e:
             if 'called on unfilterable stream' in str(e):
                 raise UnsupportedImageTypeError(repr(self)) from e
@@ -722,14 +751,55 @@ class PdfImage(PdfImageBase):
         self, decode_level: StreamDecodeLevel = StreamDecodeLevel.specialized
     ) -> bytes:
         """Decompress this image and return it as unencoded bytes."""
+        if self._decoded is not None and decode_level == StreamDecodeLevel.specialized:
+            return self._decoded
         return self.obj.read_bytes(decode_level=decode_level)
 
     def get_stream_buffer(
         self, decode_level: StreamDecodeLevel = StreamDecodeLevel.specialized
     ) -> Buffer:
         """Access this image with the buffer protocol."""
+        if self._decoded is not None and decode_level == StreamDecodeLevel.specialized:
+            return cast(Buffer, memoryview(self._decoded))
         return self.obj.get_stream_buffer(decode_level=decode_level)
 
+    def read_depalettized(self, out: Any = None) -> Any:
+        """Return the colors of an Indexed image's pixels, looked up in its palette.
+
+        The colors are in the palette's base color space, as given by
+        :attr:`palette`, with one byte per component, in rows of
+        ``width * components`` bytes with no padding. They are looked up by a
+        native kernel in one pass.
+
+        Args:
+            out: A writable buffer of at least ``width * height * components``
+                bytes to write the colors to, such as a ``bytearray`` or numpy
+                array. If omitted, a new ``bytearray`` is returned.
+
+        Returns:
+            The buffer written to.
+
+        Raises:
+            ValueError: If the image is not an Indexed image, or *out* is too
+                small.
+            NotImplementedError: If the palette's base color space is not
+                grayscale, RGB or CMYK.
+        """
+        palette = self.palette
+        if palette is None:
+            raise ValueError("image does not have a palette")
+        components = {'L': 1, 'RGB': 3, 'CMYK': 4}.get(palette.base_colorspace)
+        if components is None:
+            raise NotImplementedError(f"palette with {palette.base_colorspace} colors")
+        return _transcoding.expand_palette(
+            self.read_bytes(),
+            self.size,
+            self.bits_per_component,
+            palette.palette,
+            components,
+            out,
+        )
+
     def as_pil_image(self) -> Image.Image:
         """Extract the image as a Pillow Image, using decompression as necessary.
 
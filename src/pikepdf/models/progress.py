@@ -0,0 +1,49 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Report the progress of long-running operations."""
+
+from __future__ import annotations
+
+from typing import NamedTuple
+
+
+class ProgressEvent(NamedTuple):
+    """The progress of a save, stream check or job, passed to ``progress_event``.
+
+    Events are sent each time the operation advances by one percent. See
+    :meth:`pikepdf.Pdf.save`, :meth:`pikepdf.Pdf.check_pdf_syntax` and
+    :meth:`pikepdf.Job.run`.
+    """
+
+    phase: str
+    """What is in progress: ``'write'`` while saving, ``'decode'`` while
+    checking streams, or ``'job'`` while a job writes its output."""
+
+    percent: int
+    """Percentage complete, from 0 to 100."""
+
+    objects_written: int
+    """Approximate number of objects processed so far, estimated from ``percent``.
+    A linearized save processes each object twice."""
+
+    objects_total: int
+    """Number of objects in the PDF, or 0 if not known."""
+
+    bytes_written: int
+    """Bytes of output produced so far, or 0 if not known. While checking
+    streams, this counts the PDF as it would be written with every stream
+    decoded, which is mostly decoded stream data."""
+
+    elapsed: float
+    """Seconds since the operation began."""
+
+    @property
+    def bytes_per_second(self) -> float:
+        """Average output rate so far."""
+        return self.bytes_written / self.elapsed if self.elapsed > 0 else 0.0
+
+    @property
+    def objects_per_second(self) -> float:
+        """Average object rate so far."""
+        return self.objects_written / self.elapsed if self.elapsed > 0 else 0.0
@@ -7,12 +7,30 @@ from __future__ import annotations
 
 from pikepdf._core import (
     get_decimal_precision,
+    get_flate_backend,
+    get_flate_backends,
+    get_mmap_populate_threshold,
+    get_output_buffer_size,
+    get_stream_read_cache,
     set_decimal_precision,
+    set_flate_backend,
     set_flate_compression_level,
+    set_mmap_populate_threshold,
+    set_output_buffer_size,
+    set_stream_read_cache,
 )
 
 __all__ = [
     'get_decimal_precision',
+    'get_flate_backend',
+    'get_flate_backends',
+    'get_mmap_populate_threshold',
+    'get_output_buffer_size',
+    'get_stream_read_cache',
     'set_decimal_precision',
+    'set_flate_backend',
     'set_flate_compression_level',
+    'set_mmap_populate_threshold',
+    'set_output_buffer_size',
+    'set_stream_read_cache',
 ]
@@ -0,0 +1,181 @@
+# SPDX-FileCopyrightText: 2026 James R. Barlow
+# SPDX-License-Identifier: MPL-2.0
+
+"""Saved cross-reference indexes, to reopen large PDFs quickly.
+
+When a PDF is opened, qpdf reads its cross-reference tables or streams to find
+where each object is stored, and if they are damaged, reconstructs them by scanning
+the whole file. For large files that are opened many times, this work can be saved
+in a small index file next to the PDF (a "sidecar") and reused.
+
+The index contains the resolved object offset table and trailer, stored as a PDF
+cross-reference stream. When the PDF is opened with the index, pikepdf presents the
+index to qpdf as though it had been appended to the file as an incremental update,
+so qpdf reads it instead of the file's own cross-reference sections. The PDF itself
+is never modified.
+
+An index is only used if the file's size, modification time and a hash of its
+first and last 64 KiB match the values recorded when the index was built.
+Otherwise it is ignored as stale.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import json
+import os
+from contextlib import suppress
+from pathlib import Path
+
+from pikepdf._core import Pdf
+from pikepdf._io import atomic_overwrite
+
+INDEX_SUFFIX = '.xrefidx'
+
+_MAGIC = b'%pikepdf-xref-index 1\n'
+_HASH_BLOCK_SIZE = 64 * 1024
+_HEADER_SEARCH_SIZE = 1024  # Same as qpdf
+
+
+def default_index_path(filename: str | os.PathLike) -> Path:
+    """Return the default sidecar path of the xref index for *filename*."""
+    filename = Path(filename)
+    return filename.with_name(filename.name + INDEX_SUFFIX)
+
+
+def _file_key(filename: Path) -> dict:
+    """Return the values that identify the current contents of a file."""
+    with filename.open('rb') as f:
+        st = os.fstat(f.fileno())
+        head = f.read(_HASH_BLOCK_SIZE)
+        digest = hashlib.sha256(head)
+        if st.st_size > _HASH_BLOCK_SIZE:
+            f.seek(max(st.st_size - _HASH_BLOCK_SIZE, _HASH_BLOCK_SIZE))
+            digest.update(f.read())
+    header_offset = head.find(b'%PDF-', 0, _HEADER_SEARCH_SIZE)
+    return {
+        'size': st.st_size,
+        'mtime_ns': st.st_mtime_ns,
+        'sha256': digest.hexdigest(),
+        # qpdf measures offsets from the PDF header, if it is not at the start
+        'header_offset': max(header_offset, 0),
+    }
+
+
+def _read_index(index_path: Path, key: dict) -> bytes | None:
+    """Return the index data in *index_path* if it matches *key*, else None."""
+    try:
+        with index_path.open('rb') as f:
+            if f.readline() != _MAGIC:
+                return None
+            try:
+                saved_key = json.loads(f.readline())
+            except ValueError:
+                return None
+            if saved_key != key:
+                return None
+            return f.read() or None
+    except OSError:
+        return None
+
+
+def _write_index(pdf: Pdf, index_path: Path, key: dict) -> None:
+    """Write the xref index for *pdf*, which was opened from a file with *key*."""
+    data = pdf._xref_index(key['size'] - key['header_offset'])
+    with atomic_overwrite(index_path) as f:
+        f.write(_MAGIC)
+        f.write(json.dumps(key, sort_keys=True).encode('ascii') + b'\n')
+        f.write(data)
+
+
+def build_index(
+    filename: str | os.PathLike,
+    index_path: str | os.PathLike | None = None,
+    *,
+    password: str | bytes = '',
+) -> Path:
+    """Build an xref index for a PDF, replacing any existing index.
+
+    Args:
+        filename: The PDF to index.
+        index_path: Where to save the index. By default, the index is saved next to
+            the PDF, with the suffix ``.xrefidx`` appended to its name.
+        password: Password to open the PDF, if it is encrypted. The password is not
+            saved in the index.
+
+    Returns:
+        The path of the index.
+    """
+    filename = Path(filename)
+    index_path = Path(index_path) if index_path else default_index_path(filename)
+    key = _file_key(filename)
+    with Pdf.open(filename, password=password, inherit_page_attributes=False) as pdf:
+        _write_index(pdf, index_path, key)
+    return index_path
+
+
+def verify_index(
+    filename: str | os.PathLike,
+    index_path: str | os.PathLike | None = None,
+    *,
+    password: str | bytes = '',
+) -> bool:
+    """Check that an xref index is current and can be used to open its PDF.
+
+    The index must match the PDF's current size, modification time and content
+    hash, and the PDF must open with the index without any warnings.
+
+    Args:
+        filename: The PDF that was indexed.
+        index_path: The index. Defaults to :func:`default_index_path`.
+        password: Password to open the PDF, if it is encrypted.
+    """
+    filename = Path(filename)
+    index_path = Path(index_path) if index_path else default_index_path(filename)
+    data = _read_index(index_path, _file_key(filename))
+    if data is None:
+        return False
+    try:
+        with filename.open('rb') as stream:
+            pdf = Pdf._open(
+                stream,
+                password=password,
+                attempt_recovery=False,
+                inherit_page_attributes=False,
+                description=str(filename),
+                xref_index=data,
+            )
+            with pdf:
+                return not pdf.get_warnings()
+    except Exception:  # pylint: disable=broad-except
+        return False
+
+
+def _load_for_open(
+    filename: str | os.PathLike, index_path: str | os.PathLike | None = None
+) -> tuple[bytes, dict]:
+    """Load a current xref index for *filename*, for use by :meth:`Pdf.open`.
+
+    Returns the index data, or empty bytes if there is no current index, and the
+    key of the file, for :func:`_save_after_open`.
+    """
+    filename = Path(filename)
+    index_path = Path(index_path) if index_path else default_index_path(filename)
+    key = _file_key(filename)
+    return _read_index(index_path, key) or b'', key
+
+
+def _save_after_open(
+    pdf: Pdf,
+    filename: str | os.PathLike,
+    index_path: str | os.PathLike | None,
+    key: dict,
+) -> None:
+    """Save an xref index for a PDF that was just opened without one.
+
+    Failure to write the index is not an error, since it is only a cache.
+    """
+    filename = Path(filename)
+    index_path = Path(index_path) if index_path else default_index_path(filename)
+    with suppress(OSError):
+        _write_index(pdf, index_path, key)
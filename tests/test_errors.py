@@ -85,3 +85,43 @@ def test_pdf_syntax_check_progress(resources):
         p.check_pdf_syntax(progress_fn)
 
     assert called, "progress function not called"
+
+
+def test_pdf_syntax_check_cancelled(resources):
+    events = []
+    with Pdf.open(resources / 'outlines.pdf') as p:
+        assert p.check_pdf_syntax(progress_event=events.append) == []
+        with pytest.raises(pikepdf.OperationCancelledError):
+            p.check_pdf_syntax(cancellation_token=pikepdf.CancellationToken(timeout=0))
+    assert events and all(e.phase == 'decode' for e in events)
+
+
+def test_pdf_syntax_check_cancelled_while_checking(resources):
+    token = pikepdf.CancellationToken()
+    events = []
+
+    def cancel_midway(event):
+        events.append(event)
+        if event.percent >= 10:
+            token.cancel()
+
+    with Pdf.open(resources / 'outlines.pdf') as p:
+        with pytest.raises(pikepdf.OperationCancelledError):
+            p.check_pdf_syntax(progress_event=cancel_midway, cancellation_token=token)
+    assert events and events[-1].percent < 100
+
+
+def test_validate_streams(resources):
+    with Pdf.open(resources / 'outlines.pdf') as p:
+        assert p.validate_streams(threads=2) == []
+        assert p.check_pdf_syntax(threads=2) == []
+
+        bad = p.make_stream(b'this is not flate data')
+        bad.Filter = Name.FlateDecode
+        p.Root.Bad = bad
+        failures = p.validate_streams()
+        assert [f['objgen'] for f in failures] == [bad.objgen]
+        assert failures[0]['filter'] == '/FlateDecode'
+        assert any(
+            problem.startswith('ERROR') for problem in p.check_pdf_syntax(threads=0)
+        )
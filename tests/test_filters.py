@@ -68,6 +68,14 @@ def test_filter_thru(pal, filter, expected):
     assert after == expected
 
 
+def test_filter_decoded_stream_cache(pal):
+    pal.enable_decoded_stream_cache()
+    page = pal.pages[0]
+    assert page.obj.Contents.read_bytes() != b''
+    page.add_content_token_filter(FilterDrop())
+    assert page.obj.Contents.read_bytes() == b''
+
+
 def test_filter_names(pal):
     page = pal.pages[0]
     filter = FilterCollectNames()
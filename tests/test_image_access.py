@@ -33,6 +33,7 @@ from pikepdf import (
     PdfInlineImage,
     Stream,
     StreamDecodeLevel,
+    extract_all_images,
     parse_content_stream,
 )
 from pikepdf.models._transcoding import _next_multiple, unpack_subbyte_pixels
@@ -871,6 +872,112 @@ def test_palette_nonrgb(base, hival, bits, palette, expect_type, expect_mode):
     assert pim.mode == expect_mode
 
 
+def test_read_depalettized():
+    pdf = pikepdf.new()
+    imobj = Stream(
+        pdf,
+        b'\x1b\xe4',
+        BitsPerComponent=2,
+        ColorSpace=Array([Name.Indexed, Name.DeviceCMYK, 3, CMYK_PALETTE]),
+        Width=4,
+        Height=2,
+        Type=Name.XObject,
+        Subtype=Name.Image,
+    )
+    pim = PdfImage(imobj)
+    colors = [CMYK_RED, CMYK_GREEN, CMYK_BLUE, CMYK_PINK]
+    expected = b''.join(colors[i] for i in [0, 1, 2, 3, 3, 2, 1, 0])
+    assert pim.read_depalettized() == expected
+
+    out = bytearray(len(expected) + 4)
+    assert pim.read_depalettized(out) is out
+    assert out[: len(expected)] == expected
+    with pytest.raises(ValueError, match='too small'):
+        pim.read_depalettized(bytearray(len(expected) - 1))
+
+    im = pim.as_pil_image()
+    assert im.mode == 'CMYK'
+    assert im.getpixel((1, 0)) == tuple(CMYK_GREEN)
+    assert im.getpixel((1, 1)) == tuple(CMYK_BLUE)
+
+
+def test_read_depalettized_numpy():
+    np = pytest.importorskip('numpy')
+    pdf = pikepdf.new()
+    imobj = Stream(
+        pdf,
+        bytes(range(6)),
+        BitsPerComponent=8,
+        ColorSpace=Array([Name.Indexed, Name.DeviceRGB, 3, bytes(range(12))]),
+        Width=3,
+        Height=2,
+        Type=Name.XObject,
+        Subtype=Name.Image,
+    )
+    pim = PdfImage(imobj)
+    out = np.zeros((2, 3, 3), dtype=np.uint8)
+    pim.read_depalettized(out)
+    # Indexes 4 and 5 are past the end of the palette, so use the last entry
+    assert out.tolist() == [
+        [[0, 1, 2], [3, 4, 5], [6, 7, 8]],
+        [[9, 10, 11], [9, 10, 11], [9, 10, 11]],
+    ]
+
+
+def test_read_depalettized_not_indexed(congress):
+    with pytest.raises(ValueError, match='palette'):
+        PdfImage(congress[0]).read_depalettized()
+
+
+def test_extract_all_images(resources, tmp_path):
+    with (
+        Pdf.open(resources / 'congress.pdf') as congress,
+        Pdf.open(resources / 'image-mono-inline.pdf') as inline_pdf,
+    ):
+        pdf = Pdf.new()
+        jpeg = pdf.copy_foreign(next(iter(congress.pages[0].images.values())))
+        image_args = dict(
+            Type=Name.XObject,
+            Subtype=Name.Image,
+            Width=32,
+            Height=32,
+            BitsPerComponent=8,
+            ColorSpace=Name.DeviceGray,
+        )
+        gray_data = bytes(range(256)) * 4
+        gray = pdf.make_indirect(Stream(pdf, gray_data, **image_args))
+        short = pdf.make_indirect(Stream(pdf, b'\x00' * 10, **image_args))
+        pdf.add_blank_page()
+        pdf.add_blank_page()
+        pdf.pages[0].Resources = Dictionary(
+            XObject=Dictionary(Im0=jpeg, Im1=gray, Im2=short)
+        )
+        pdf.pages[1].Resources = Dictionary(XObject=Dictionary(Im1=gray))
+        pdf.pages.append(inline_pdf.pages[0])
+
+        manifest = extract_all_images(pdf, tmp_path / 'out', workers=2)
+        jpeg_data = jpeg.read_raw_bytes()
+
+    xobjects = [entry for entry in manifest if entry.objgen is not None]
+    assert [(entry.name, entry.pages) for entry in xobjects] == [
+        ('/Im0', (0,)),
+        ('/Im1', (0, 1)),
+        ('/Im2', (0,)),
+    ]
+    assert xobjects[0].path.suffix == '.jpg'
+    assert xobjects[0].path.read_bytes() == jpeg_data
+    assert xobjects[1].path.suffix == '.png'
+    with Image.open(xobjects[1].path) as im:
+        assert im.tobytes() == gray_data
+    assert xobjects[2].path is None and xobjects[2].error
+
+    inline_images = [entry for entry in manifest if entry.objgen is None]
+    assert inline_images
+    for entry in inline_images:
+        assert entry.page == 2 and entry.name == ''
+        assert entry.error is None and entry.path.exists()
+
+
 def test_extract_to_mutex_params(sandwich):
     pdfimage = PdfImage(sandwich[0])
     with pytest.raises(ValueError, match="Cannot set both"):
@@ -1071,6 +1178,45 @@ def test_grayscale_stride(spec):
         assert imdata_unpacked[idx] == pixel
 
 
+def _unpack_subbyte_reference(packed, bits, scale, invert):
+    max_sample = (1 << bits) - 1
+    out = bytearray()
+    for byte in packed:
+        for shift in range(8 - bits, -1, -bits):
+            sample = (byte >> shift) & max_sample
+            if invert:
+                sample = max_sample - sample
+            out.append(int(sample * scale))
+    return out
+
+
+@given(
+    packed=st.binary(min_size=1, max_size=300),
+    bits=st.sampled_from([1, 2, 4]),
+    scale=st.sampled_from([0, 1, 0.5]),
+    invert=st.booleans(),
+)
+def test_unpack_subbyte_pixels(packed, bits, scale, invert):
+    width = len(packed) * (8 // bits)
+    unpacked, stride = unpack_subbyte_pixels(
+        packed, (width, 1), bits, scale, invert=invert
+    )
+    assert stride == width
+    if scale == 0:
+        scale = 255 / ((1 << bits) - 1)
+    assert bytes(unpacked) == _unpack_subbyte_reference(packed, bits, scale, invert)
+
+
+def test_unpack_subbyte_pixels_short_input():
+    unpacked, stride = unpack_subbyte_pixels(b'\x1b', (3, 2), 2)
+    assert stride == 4
+    assert bytes(unpacked) == b'\x00\x55\xaa\xff' + b'\x00' * 4
+    with pytest.raises(NotImplementedError):
+        unpack_subbyte_pixels(b'\x00', (1, 1), 3)
+    with pytest.raises(ValueError):
+        unpack_subbyte_pixels(b'\x00', (1, 1), 4, scale=20)
+
+
 @requires_pdfimages
 @given(spec=valid_random_image_spec())
 def test_random_image(spec, tmp_path_factory):
@@ -3,16 +3,22 @@
 
 from __future__ import annotations
 
+import asyncio
+import gzip
 import logging
 import os
 import os.path
 import pathlib
+import random
+import threading
 from io import BytesIO, FileIO
 from shutil import copy
 
 import pytest
 
 import pikepdf
+import pikepdf.settings
+import pikepdf.xref_index
 from pikepdf import Pdf, PdfError
 from pikepdf._io import atomic_overwrite
 
@@ -42,6 +48,132 @@ def test_weird_output_stream(sandwich):
     assert bio.getvalue() == lbio.getvalue()
 
 
+class WriteOnlyStream:
+    """A non-seekable, write-only target, like a pipe or socket."""
+
+    def __init__(self):
+        self.data = bytearray()
+
+    def write(self, b):
+        self.data += b
+        return len(b)
+
+
+def test_save_write_only_stream(sandwich):
+    bio = BytesIO()
+    target = WriteOnlyStream()
+    sandwich.save(bio, static_id=True)
+    sandwich.save(target, static_id=True)
+    assert bytes(target.data) == bio.getvalue()
+
+
+def test_iter_save(sandwich):
+    bio = BytesIO()
+    sandwich.save(bio, static_id=True)
+    chunks = list(sandwich.iter_save(chunk_size=1000, max_chunks=2, static_id=True))
+    assert all(len(chunk) == 1000 for chunk in chunks[:-1])
+    assert 0 < len(chunks[-1]) <= 1000
+    assert b''.join(chunks) == bio.getvalue()
+    assert sandwich.last_save_stats['bytes_written'] == len(bio.getvalue())
+
+
+def test_iter_save_abandoned(sandwich):
+    chunks = sandwich.iter_save(chunk_size=100, max_chunks=1)
+    assert len(next(chunks)) == 100
+    chunks.close()  # Must not hang waiting for the save
+    with pytest.raises(ValueError):
+        sandwich.iter_save(chunk_size=0)
+    with pytest.raises(TypeError):
+        list(sandwich.iter_save(no_such_option=True))
+    with pytest.raises(ValueError, match='incremental'):
+        list(sandwich.iter_save(incremental=True))
+
+
+def test_iter_save_while_reading(resources):
+    # The save runs on another thread without the GIL, so the Pdf cannot be used
+    # until it finishes
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        bio = BytesIO()
+        pdf.save(bio, static_id=True)
+        stream = next(obj for obj in pdf.objects if isinstance(obj, pikepdf.Stream))
+        page = pdf.pages[0]
+        chunks = pdf.iter_save(chunk_size=100, max_chunks=1, static_id=True)
+        data = [next(chunks)]
+        with pytest.raises(RuntimeError, match='being saved'):
+            pdf.Root
+        with pytest.raises(RuntimeError, match='being saved'):
+            stream.read_raw_bytes()
+        with pytest.raises(RuntimeError, match='being saved'):
+            page.mediabox
+        with pytest.raises(RuntimeError, match='being saved'):
+            pdf.save(BytesIO())
+        data.extend(chunks)
+        assert b''.join(data) == bio.getvalue()
+        stream.read_raw_bytes()
+
+
+def test_save_progress_event(sandwich):
+    events = []
+    bio = BytesIO()
+    sandwich.save(bio, progress_event=events.append)
+    assert events[-1].percent == 100
+    assert all(e.phase == 'write' for e in events)
+    assert events[-1].objects_written == events[-1].objects_total > 0
+    bytes_written = [e.bytes_written for e in events]
+    assert bytes_written == sorted(bytes_written)
+    assert bytes_written[-1] <= len(bio.getvalue())
+    assert events[-1].elapsed >= events[0].elapsed >= 0
+
+
+def test_save_cancelled(sandwich, tmp_path):
+    token = pikepdf.CancellationToken()
+    assert not token.cancelled and token.remaining is None
+    token.cancel()
+    assert token.cancelled
+    with pytest.raises(pikepdf.OperationCancelledError):
+        sandwich.save(tmp_path / 'out.pdf', cancellation_token=token)
+    assert not (tmp_path / 'out.pdf').exists()
+
+    expired = pikepdf.CancellationToken(timeout=0)
+    assert expired.cancelled and expired.remaining == 0
+    with pytest.raises(pikepdf.OperationCancelledError, match='time budget'):
+        sandwich.save(BytesIO(), cancellation_token=expired)
+    with pytest.raises(pikepdf.OperationCancelledError):
+        list(sandwich.iter_save(cancellation_token=expired))
+    # Only that save was cancelled
+    sandwich.save(BytesIO(), cancellation_token=pikepdf.CancellationToken(60))
+
+
+def test_save_cancelled_while_saving(resources, tmp_path):
+    token = pikepdf.CancellationToken()
+    events = []
+
+    def cancel_midway(event):
+        events.append(event)
+        if event.percent >= 10:
+            token.cancel()
+
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        with pytest.raises(pikepdf.OperationCancelledError) as excinfo:
+            pdf.save(
+                tmp_path / 'out.pdf',
+                progress_event=cancel_midway,
+                cancellation_token=token,
+            )
+    assert isinstance(excinfo.value, PdfError)
+    assert events and events[-1].percent < 100
+    assert not (tmp_path / 'out.pdf').exists()
+
+
+def test_aiter_save(sandwich):
+    async def collect():
+        return [chunk async for chunk in sandwich.aiter_save(static_id=True)]
+
+    bio = BytesIO()
+    sandwich.save(bio, static_id=True)
+    assert b''.join(asyncio.run(collect())) == bio.getvalue()
+
+
 def test_overwrite_with_memory_file(outdir):
     (outdir / 'example.pdf').touch()
     pdf = Pdf.new()
@@ -119,6 +251,7 @@ def test_file_without_fileno(resources):
         assert pdf.filename
 
 
+@pytest.mark.skipif(os.name != 'nt', reason="POSIX does not use Python's mmap")
 def test_file_deny_mmap(resources, monkeypatch):
     import mmap
 
@@ -135,6 +268,50 @@ def test_file_deny_mmap(resources, monkeypatch):
         assert len(pdf.pages) == 1
 
 
+@pytest.mark.skipif(os.name == 'nt', reason="Windows uses Python's mmap")
+def test_file_deny_native_mmap(resources, tmp_path):
+    class FileWithDirectoryFileNo(FileIO):
+        def __init__(self, *args, **kwargs):
+            super().__init__(*args, **kwargs)
+            self.dir_fd = os.open(tmp_path, os.O_RDONLY)
+
+        def fileno(self):
+            return self.dir_fd  # Directories cannot be memory mapped
+
+        def close(self):
+            os.close(self.dir_fd)
+            super().close()
+
+    with FileWithDirectoryFileNo(resources / 'pal.pdf', 'rb') as f:
+        with pytest.raises(OSError):
+            Pdf.open(f, access_mode=pikepdf._core.AccessMode.mmap_only)
+
+    with FileWithDirectoryFileNo(resources / 'pal.pdf', 'rb') as f:
+        with Pdf.open(f, access_mode=pikepdf._core.AccessMode.mmap) as pdf:
+            assert len(pdf.pages) == 1
+
+
+def test_mmap_empty_file(tmp_path):
+    empty = tmp_path / 'empty.pdf'
+    empty.touch()
+    with pytest.raises(ValueError):
+        Pdf.open(empty, access_mode=pikepdf._core.AccessMode.mmap_only)
+
+
+@pytest.mark.parametrize('threshold', [0, 1 << 30])
+def test_mmap_save_and_check(resources, outpdf, threshold):
+    saved = pikepdf.settings.set_mmap_populate_threshold(threshold)
+    try:
+        with Pdf.open(
+            resources / 'fourpages.pdf', access_mode=pikepdf._core.AccessMode.mmap_only
+        ) as pdf:
+            assert pdf.check_pdf_syntax() == []
+            pdf.save(outpdf)
+            assert len(pdf.pages) == 4
+    finally:
+        pikepdf.settings.set_mmap_populate_threshold(saved)
+
+
 def test_mmap_only_file(resources):
     class UnreadableFile(FileIO):
         def readinto(self, *args):
@@ -147,6 +324,467 @@ def test_mmap_only_file(resources):
         Pdf.open(f, access_mode=pikepdf._core.AccessMode.stream)
 
 
+def test_pread_access(resources):
+    with Pdf.open(
+        resources / 'fourpages.pdf', access_mode=pikepdf._core.AccessMode.pread
+    ) as pdf:
+        assert len(pdf.pages) == 4
+        pread_bytes = pdf.pages[0].Contents.read_bytes()
+    with Pdf.open(
+        resources / 'fourpages.pdf', access_mode=pikepdf._core.AccessMode.stream
+    ) as pdf:
+        assert pdf.pages[0].Contents.read_bytes() == pread_bytes
+
+
+def test_pread_does_not_call_python(resources):
+    class UnreadableFile(FileIO):
+        def readinto(self, *args):
+            raise ExpectedError("can't read, you have to pread me")
+
+        read = readinto  # PyPy uses read() not readinto()
+
+    f = UnreadableFile(resources / 'pal.pdf', 'rb')
+    if os.name == 'nt':
+        with pytest.raises(ExpectedError):
+            Pdf.open(f, access_mode=pikepdf._core.AccessMode.pread)
+    else:
+        with Pdf.open(f, access_mode=pikepdf._core.AccessMode.pread) as pdf:
+            assert len(pdf.pages) == 1
+
+
+def test_pread_fallback_to_stream(resources):
+    class FileWithoutFileNo(FileIO):
+        def fileno(self):
+            raise ExpectedError("nope!")
+
+    f = FileWithoutFileNo(resources / 'pal.pdf', 'rb')
+    with Pdf.open(f, access_mode=pikepdf._core.AccessMode.pread) as pdf:
+        assert len(pdf.pages) == 1
+
+    bio = BytesIO((resources / 'pal.pdf').read_bytes())
+    with Pdf.open(bio, access_mode=pikepdf._core.AccessMode.pread) as pdf:
+        assert len(pdf.pages) == 1
+
+
+class CountingBytesIO(BytesIO):
+    """Version of BytesIO that counts calls to read, readinto and write."""
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self.reads = 0
+        self.writes = 0
+
+    def write(self, b):
+        self.writes += 1
+        return super().write(b)
+
+    def readinto(self, b):
+        self.reads += 1
+        return super().readinto(b)
+
+    def read(self, size=-1):
+        self.reads += 1
+        return super().read(size)
+
+
+@pytest.fixture
+def stream_read_cache():
+    saved = pikepdf.settings.get_stream_read_cache()
+    yield
+    pikepdf.settings.set_stream_read_cache(*saved)
+
+
+@pytest.mark.parametrize('max_blocks', [0, 1, 16])
+def test_stream_read_cache(resources, stream_read_cache, max_blocks):
+    pikepdf.settings.set_stream_read_cache(block_size=512, max_blocks=max_blocks)
+    data = (resources / 'fourpages.pdf').read_bytes()
+    with Pdf.open(CountingBytesIO(data)) as pdf:
+        assert len(pdf.pages) == 4
+        assert pdf.check_pdf_syntax() == []
+
+
+def test_stream_read_cache_reduces_reads(resources, stream_read_cache):
+    data = (resources / 'fourpages.pdf').read_bytes()
+    pikepdf.settings.set_stream_read_cache(max_blocks=0)
+    uncached = CountingBytesIO(data)
+    with Pdf.open(uncached) as pdf:
+        pdf.check_pdf_syntax()
+
+    pikepdf.settings.set_stream_read_cache()
+    cached = CountingBytesIO(data)
+    with Pdf.open(cached) as pdf:
+        pdf.check_pdf_syntax()
+    assert cached.reads < uncached.reads
+
+
+def test_stream_read_cache_invalid(stream_read_cache):
+    with pytest.raises(ValueError):
+        pikepdf.settings.set_stream_read_cache(block_size=1)
+
+
+@pytest.fixture
+def output_buffer_size():
+    saved = pikepdf.settings.get_output_buffer_size()
+    yield
+    pikepdf.settings.set_output_buffer_size(saved)
+
+
+@pytest.mark.parametrize('buffer_size', [0, 100, 4096, 1024 * 1024])
+def test_output_buffer(resources, output_buffer_size, buffer_size):
+    pikepdf.settings.set_output_buffer_size(buffer_size)
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        assert pdf.last_save_stats is None
+        bio = CountingBytesIO()
+        pdf.save(bio, static_id=True)
+        stats = pdf.last_save_stats
+    assert stats['bytes_written'] == len(bio.getvalue())
+    assert stats['stream_writes'] == bio.writes
+    if buffer_size == 0:
+        assert stats['stream_writes'] == stats['chunks']
+    elif buffer_size > len(bio.getvalue()):
+        assert stats['stream_writes'] == 1
+    else:
+        assert stats['stream_writes'] < stats['chunks']
+
+    pikepdf.settings.set_output_buffer_size(0)
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        unbuffered = BytesIO()
+        pdf.save(unbuffered, static_id=True)
+    assert unbuffered.getvalue() == bio.getvalue()
+
+
+def test_save_direct_to_file(resources, tmp_path):
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        pdf.save(tmp_path / 'out.pdf', static_id=True)
+        assert pdf.last_save_stats['direct'] == (os.name != 'nt')
+        bio = BytesIO()
+        pdf.save(bio, static_id=True)
+        assert not pdf.last_save_stats['direct']
+    assert (tmp_path / 'out.pdf').read_bytes() == bio.getvalue()
+
+    # Replacing an existing file goes through a temporary file, also written directly
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        pdf.save(tmp_path / 'out.pdf', static_id=True)
+        assert pdf.last_save_stats['direct'] == (os.name != 'nt')
+    assert (tmp_path / 'out.pdf').read_bytes() == bio.getvalue()
+
+
+def test_save_not_direct_to_file_wrapper(resources, tmp_path):
+    # GzipFile reports the fileno() of the file it compresses into
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        with gzip.open(tmp_path / 'out.pdf.gz', 'wb') as f:
+            pdf.save(f, static_id=True)
+        assert not pdf.last_save_stats['direct']
+        bio = BytesIO()
+        pdf.save(bio, static_id=True)
+    with gzip.open(tmp_path / 'out.pdf.gz', 'rb') as f:
+        assert f.read() == bio.getvalue()
+
+
+def test_save_direct_keeps_stream_position(resources, tmp_path):
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        with open(tmp_path / 'out.bin', 'wb') as f:
+            f.write(b'prefix\n')  # Still in the file object's buffer
+            pdf.save(f, static_id=True)
+            assert f.tell() == len(b'prefix\n') + pdf.last_save_stats['bytes_written']
+            f.write(b'suffix')
+    data = (tmp_path / 'out.bin').read_bytes()
+    assert data.startswith(b'prefix\n%PDF-')
+    assert data.endswith(b'%%EOF\nsuffix')
+
+
+@pytest.fixture
+def uncompressed_streams_pdf(resources):
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        pdf.Root.Extra = pikepdf.Array(
+            pdf.make_stream(b'%d 0 0 1 0 0 cm\n' % n * 500) for n in range(20)
+        )
+        yield pdf
+
+
+def test_compress_threads(uncompressed_streams_pdf):
+    pdf = uncompressed_streams_pdf
+    count = len(pdf.objects)
+    outputs = []
+    for threads in [None, 1, 4, 0]:
+        bio = BytesIO()
+        pdf.save(
+            bio, deterministic_id=True, recompress_flate=True, compress_threads=threads
+        )
+        if threads is not None:
+            assert pdf.last_save_stats['precompressed_streams'] >= 20
+        else:
+            assert pdf.last_save_stats['precompressed_streams'] == 0
+        outputs.append(bio.getvalue())
+    assert outputs[1] == outputs[2] == outputs[3]
+
+    # The Pdf is unchanged by saving, and has no more objects than before
+    assert pdf.Root.Extra[0].get('/Filter') is None
+    assert pdf.Root.Extra[0].read_raw_bytes() == b'0 0 0 1 0 0 cm\n' * 500
+    assert len(pdf.objects) == count
+    for linearize in [False, True]:
+        pdf.save(BytesIO(), compress_threads=2, linearize=linearize)
+        assert pdf.last_save_stats['precompressed_streams'] >= 20
+        assert len(pdf.objects) == count
+
+    with Pdf.open(BytesIO(outputs[0])) as serial, Pdf.open(BytesIO(outputs[1])) as pre:
+        for a, b in zip(serial.Root.Extra, pre.Root.Extra):
+            assert a.Filter == b.Filter == pikepdf.Name.FlateDecode
+        assert len(serial.objects) == len(pre.objects)
+        for a, b in zip(serial.objects, pre.objects):
+            if isinstance(a, pikepdf.Stream):
+                assert a.read_bytes() == b.read_bytes()
+
+
+def test_compression_policy(uncompressed_streams_pdf):
+    pdf = uncompressed_streams_pdf
+    noise = random.Random(42).randbytes(50000)
+    pdf.Root.Noise = pdf.make_stream(noise)
+    policy = pikepdf.CompressionPolicy(other_level=9)
+    bio = BytesIO()
+    pdf.save(bio, recompress_flate=True, compression_policy=policy)
+    decisions = {
+        d['objgen']: d for d in pdf.last_save_stats['compression_decisions']
+    }
+
+    noise_decision = decisions[pdf.Root.Noise.objgen]
+    assert not noise_decision['compressed']
+    assert noise_decision['estimated_gain'] < policy.min_gain
+    extra_decision = decisions[pdf.Root.Extra[0].objgen]
+    assert extra_decision['compressed']
+    if pikepdf._core._per_stream_compression_levels():
+        assert extra_decision['level'] == 9
+    else:
+        assert extra_decision['level'] == -1
+    assert extra_decision['class'] == 'other'
+    content_decision = decisions[pdf.pages[0].Contents.objgen]
+    assert content_decision['class'] == 'content'
+    assert content_decision['level'] == policy.content_level
+
+    with Pdf.open(bio) as saved:
+        assert '/Filter' not in saved.Root.Noise
+        assert saved.Root.Noise.read_bytes() == noise
+        assert saved.Root.Extra[0].Filter == pikepdf.Name.FlateDecode
+
+
+def test_compression_policy_leaves_global_level(uncompressed_streams_pdf):
+    pdf = uncompressed_streams_pdf
+    reference = BytesIO()
+    pdf.save(reference, deterministic_id=True, recompress_flate=True)
+    policy = pikepdf.CompressionPolicy(
+        min_gain=0, content_level=0, font_level=0, image_level=0, other_level=0
+    )
+    with Pdf.open(BytesIO(reference.getvalue())) as other:
+        stop = threading.Event()
+
+        def save_with_policy():
+            while not stop.is_set():
+                other.save(BytesIO(), recompress_flate=True, compression_policy=policy)
+
+        thread = threading.Thread(target=save_with_policy)
+        thread.start()
+        try:
+            for _ in range(10):
+                bio = BytesIO()
+                pdf.save(bio, deterministic_id=True, recompress_flate=True)
+                assert bio.getvalue() == reference.getvalue()
+        finally:
+            stop.set()
+            thread.join()
+
+
+def test_compression_policy_invalid_level(uncompressed_streams_pdf):
+    with pytest.raises(ValueError, match='compression level'):
+        uncompressed_streams_pdf.save(
+            BytesIO(), compression_policy=pikepdf.CompressionPolicy(font_level=10)
+        )
+
+
+def test_incremental_save(resources, tmp_path):
+    original = (resources / 'fourpages.pdf').read_bytes()
+    with Pdf.open(resources / 'fourpages.pdf', inherit_page_attributes=False) as pdf:
+        pdf.Root.Extra = pdf.make_stream(b'extra data')
+        pdf.pages[1].obj.PikeTest = 1
+        pdf.save(tmp_path / 'out.pdf', incremental=True)
+        stats = pdf.last_save_stats
+    assert stats['incremental']
+    assert stats['objects_written'] == 3  # Root, page 2, new stream
+
+    data = (tmp_path / 'out.pdf').read_bytes()
+    assert data.startswith(original)
+    assert len(data) == len(original) + stats['bytes_written']
+    with Pdf.open(tmp_path / 'out.pdf') as pdf:
+        assert not pdf.get_warnings()
+        assert len(pdf.pages) == 4
+        assert pdf.pages[1].obj.PikeTest == 1
+        assert pdf.Root.Extra.read_bytes() == b'extra data'
+
+
+@pytest.mark.parametrize('object_streams', [False, True])
+def test_incremental_save_deleted_object(resources, object_streams):
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        pdf.docinfo['/Title'] = 'Deleted'
+        source = BytesIO()
+        if object_streams:
+            pdf.save(source, object_stream_mode=pikepdf.ObjectStreamMode.generate)
+        else:
+            pdf.save(source)
+    with Pdf.open(source, inherit_page_attributes=False) as pdf:
+        info = pdf.trailer.Info.objgen
+        del pdf.trailer.Info
+        pdf._replace_object(info, None)
+        out = BytesIO()
+        pdf.save(out, incremental=True)
+    update = out.getvalue()[len(source.getvalue()) :]
+    if not object_streams:
+        assert f'00000 {info[1] + 1:05d} f '.encode() in update
+    with Pdf.open(out) as pdf:
+        assert not pdf.get_warnings()
+        assert pdf.get_object(info) is None
+        assert '/Info' not in pdf.trailer
+        assert len(pdf.pages) == 4
+
+
+def test_incremental_save_xref_stream(resources):
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        source = BytesIO()
+        pdf.save(source, object_stream_mode=pikepdf.ObjectStreamMode.generate)
+    with Pdf.open(source, inherit_page_attributes=False) as pdf:
+        pdf.docinfo['/Title'] = 'Incremental'
+        out = BytesIO()
+        pdf.save(out, incremental=True)
+    assert out.getvalue().startswith(source.getvalue())
+    with Pdf.open(out) as pdf:
+        assert not pdf.get_warnings()
+        assert pdf.docinfo.Title == 'Incremental'
+        assert len(pdf.pages) == 4
+
+
+def test_incremental_save_in_place(resources, tmp_path):
+    copy(resources / 'fourpages.pdf', tmp_path / 'in.pdf')
+    size = (tmp_path / 'in.pdf').stat().st_size
+    with Pdf.open(tmp_path / 'in.pdf', inherit_page_attributes=False) as pdf:
+        pdf.pages[0].obj.PikeTest = 1
+        pdf.save(tmp_path / 'in.pdf', incremental=True)
+        assert (tmp_path / 'in.pdf').stat().st_size == size + (
+            pdf.last_save_stats['bytes_written']
+        )
+        # A second update only contains the new change
+        pdf.pages[2].obj.PikeTest = 2
+        pdf.save(tmp_path / 'in.pdf', incremental=True)
+        assert pdf.last_save_stats['objects_written'] == 1
+    with Pdf.open(tmp_path / 'in.pdf') as pdf:
+        assert pdf.pages[0].obj.PikeTest == 1
+        assert pdf.pages[2].obj.PikeTest == 2
+
+
+def test_incremental_save_after_compress_threads(resources):
+    with Pdf.open(resources / 'fourpages.pdf', inherit_page_attributes=False) as pdf:
+        pdf.save(BytesIO(), recompress_flate=True, compress_threads=2)
+        assert pdf.last_save_stats['precompressed_streams'] > 0
+        pdf.save(BytesIO(), incremental=True)
+        assert pdf.last_save_stats['objects_written'] == 0
+
+
+@pytest.mark.parametrize('inherit', [True, False, 'lazy'])
+def test_incremental_save_page_inheritance(resources, inherit):
+    # Reading pages must not count as changing them, however they were opened
+    with Pdf.open(resources / 'fourpages.pdf', inherit_page_attributes=inherit) as pdf:
+        for page in pdf.pages:
+            _ = page.obj.keys()
+        pdf.save(BytesIO(), incremental=True)
+        assert pdf.last_save_stats['objects_written'] == 0
+        pdf.pages[1].obj.PikeTest = 1
+        pdf.save(BytesIO(), incremental=True)
+        assert pdf.last_save_stats['objects_written'] == 1
+
+
+@pytest.mark.parametrize(
+    'option',
+    [
+        {'object_stream_mode': pikepdf.ObjectStreamMode.generate},
+        {'static_id': True},
+        {'deterministic_id': True},
+        {'min_version': '1.7'},
+        {'force_version': '1.7'},
+        {'progress': lambda percent: None},
+        {'cancellation_token': pikepdf.CancellationToken()},
+        {'compress_threads': 2},
+        {'compression_policy': pikepdf.CompressionPolicy()},
+    ],
+)
+def test_incremental_save_unsupported_option(resources, option):
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        with pytest.raises(ValueError, match=next(iter(option))):
+            pdf.save(BytesIO(), incremental=True, **option)
+
+
+def test_incremental_save_unsupported(resources):
+    with Pdf.new() as pdf, pytest.raises(ValueError, match='opened from'):
+        pdf.save(BytesIO(), incremental=True)
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        with pytest.raises(ValueError, match='linearize'):
+            pdf.save(BytesIO(), incremental=True, linearize=True)
+    with Pdf.open(resources / 'graph-encrypted.pdf', password='owner') as pdf:
+        with pytest.raises(ValueError, match='encrypted'):
+            pdf.save(BytesIO(), incremental=True)
+
+
+@pytest.fixture
+def broken_xref_pdf(resources, tmp_path):
+    # startxref points to nowhere, so qpdf must reconstruct the xref table
+    data = (resources / 'graph.pdf').read_bytes()
+    broken = tmp_path / 'broken.pdf'
+    broken.write_bytes(data[: data.rindex(b'startxref')] + b'startxref\n1\n%%EOF\n')
+    return broken
+
+
+@pytest.mark.parametrize('pdfname', ['sandwich.pdf', 'fourpages.pdf', 'outlines.pdf'])
+def test_xref_index_roundtrip(resources, tmp_path, pdfname):
+    pdf_path = tmp_path / pdfname
+    copy(resources / pdfname, pdf_path)
+    index_path = pikepdf.xref_index.build_index(pdf_path)
+    assert index_path == pikepdf.xref_index.default_index_path(pdf_path)
+    assert pikepdf.xref_index.verify_index(pdf_path)
+
+    with Pdf.open(pdf_path) as plain, Pdf.open(pdf_path, xref_index=True) as indexed:
+        assert [o.objgen for o in indexed.objects] == [o.objgen for o in plain.objects]
+        assert indexed.trailer.Root.objgen == plain.trailer.Root.objgen
+        assert len(indexed.pages) == len(plain.pages)
+        indexed.check_pdf_syntax()
+
+
+def test_xref_index_skips_recovery(broken_xref_pdf):
+    with Pdf.open(broken_xref_pdf) as pdf:
+        assert pdf.get_warnings()  # Recovered
+
+    # First open recovers and saves an index; the second uses it
+    with Pdf.open(broken_xref_pdf, xref_index=True) as pdf:
+        pdf.get_warnings()
+    assert pikepdf.xref_index.verify_index(broken_xref_pdf)
+    with Pdf.open(broken_xref_pdf, xref_index=True) as pdf:
+        assert not pdf.get_warnings()
+        assert len(pdf.pages) == 1
+
+
+def test_xref_index_stale(resources, tmp_path):
+    pdf_path = tmp_path / 'graph.pdf'
+    copy(resources / 'graph.pdf', pdf_path)
+    index_path = pikepdf.xref_index.build_index(pdf_path, tmp_path / 'graph.idx')
+    with Pdf.open(pdf_path, allow_overwriting_input=True) as pdf:
+        pdf.Root.Extra = pikepdf.Dictionary(Type=pikepdf.Name.Extra)
+        pdf.save(pdf_path)
+    assert not pikepdf.xref_index.verify_index(pdf_path, index_path)
+    with Pdf.open(pdf_path, xref_index=index_path) as pdf:
+        assert pdf.Root.Extra.Type == pikepdf.Name.Extra
+    assert pikepdf.xref_index.verify_index(pdf_path, index_path)
+
+
+def test_xref_index_requires_path(resources):
+    with (resources / 'graph.pdf').open('rb') as f, pytest.raises(ValueError):
+        Pdf.open(f, xref_index=True)
+
+
 def test_save_bytesio(resources, outpdf):
     with Pdf.open(resources / 'fourpages.pdf') as input_:
         pdf = Pdf.new()
@@ -255,14 +893,17 @@ def test_memory_to_path(resources, tmp_path):
         pdf.save(str(tmp_path / 'out.pdf'))
 
 
-def test_newline_handling(resources):
-    with Pdf.open(
-        resources / 'newline-buffer-test.pdf',
-        access_mode=pikepdf._core.AccessMode.mmap_only,
-    ) as pdf:
-        assert pdf.check_pdf_syntax() == []
+@pytest.mark.parametrize(
+    'access_mode',
+    [
+        pikepdf._core.AccessMode.mmap_only,
+        pikepdf._core.AccessMode.stream,
+        pikepdf._core.AccessMode.pread,
+    ],
+)
+def test_newline_handling(resources, access_mode):
     with Pdf.open(
         resources / 'newline-buffer-test.pdf',
-        access_mode=pikepdf._core.AccessMode.stream,
+        access_mode=access_mode,
     ) as pdf:
         assert pdf.check_pdf_syntax() == []
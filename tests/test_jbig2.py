@@ -19,7 +19,7 @@ from pikepdf import (
     PdfError,
     PdfImage,
 )
-from pikepdf.jbig2 import JBIG2Decoder
+from pikepdf.jbig2 import JBIG2Decoder, NativeJBIG2Decoder
 
 
 @pytest.fixture
@@ -76,6 +76,8 @@ def test_check_specialized_decoder_fallback(
         with pytest.warns(UserWarning, match=r".*missing some specialized.*"):
             problems = pdf.check_pdf_syntax()
         assert len(problems) == 0
+        with pytest.warns(UserWarning, match=r".*missing some specialized.*"):
+            assert pdf.validate_streams(threads=2) == []
 
 
 @suppress_unraisable_jbigdec_error_warning
@@ -156,6 +158,33 @@ def test_jbig2_global_palette(first_image_in):
     assert im.getpixel((0, 0)) == 255  # Ensure loaded
 
 
+@needs_jbig2dec
+def test_jbig2_globals_cache(first_image_in):
+    xobj, pdf = first_image_in('jbig2global.pdf')
+    pikepdf.jbig2.clear_globals_cache()
+    first = xobj.read_bytes()
+    assert xobj.read_bytes() == first
+    stats = pikepdf.jbig2.get_globals_cache_stats()
+    assert stats['data_misses'] == 1
+    assert stats['data_hits'] >= 1
+
+    # Replacing the globals stream's data drops it from the cache
+    globals_ = xobj.DecodeParms.JBIG2Globals
+    globals_.write(globals_.read_bytes())
+    assert xobj.read_bytes() == first
+    assert pikepdf.jbig2.get_globals_cache_stats()['data_misses'] == 2
+
+    # So does replacing or swapping the globals object itself
+    data = globals_.read_bytes()
+    pdf._replace_object(globals_.objgen, pikepdf.Stream(pdf, data))
+    assert xobj.read_bytes() == first
+    assert pikepdf.jbig2.get_globals_cache_stats()['data_misses'] == 3
+    other = pdf.make_indirect(pikepdf.Stream(pdf, data))
+    pdf._swap_objects(globals_.objgen, other.objgen)
+    assert xobj.read_bytes() == first
+    assert pikepdf.jbig2.get_globals_cache_stats()['data_misses'] == 4
+
+
 @suppress_unraisable_jbigdec_error_warning
 def test_jbig2_error(first_image_in, patch_jbig2dec: Callable[..., None]):
     xobj, _pdf = first_image_in('jbig2global.pdf')
@@ -208,3 +237,31 @@ def test_jbig2_reports_no_version(first_image_in, patch_jbig2dec: Callable[...,
     pim = PdfImage(xobj)
     with pytest.raises(PdfError, match='read_bytes called on unfilterable stream'):
         pim.as_pil_image()
+
+
+def test_native_jbig2_not_built():
+    decoder = NativeJBIG2Decoder()
+    if decoder.available():
+        pytest.skip("pikepdf was built with libjbig2dec")
+    original = pikepdf.jbig2.get_decoder()
+    with pytest.raises(DependencyError):
+        pikepdf.jbig2.set_decoder(decoder)
+    assert pikepdf.jbig2.get_decoder() is original
+
+
+@pytest.mark.skipif(
+    not NativeJBIG2Decoder().available(), reason="pikepdf not built with libjbig2dec"
+)
+def test_native_jbig2_matches_jbig2dec(first_image_in):
+    xobj, pdf = first_image_in('jbig2global.pdf')
+    original = pikepdf.jbig2.get_decoder()
+    try:
+        pikepdf.jbig2.set_decoder(NativeJBIG2Decoder())
+        native = xobj.read_bytes()
+        assert pdf.read_streams([xobj], threads=2) == [native]
+        if not JBIG2Decoder().available():
+            return
+        pikepdf.jbig2.set_decoder(JBIG2Decoder())
+        assert xobj.read_bytes() == native
+    finally:
+        pikepdf.jbig2.set_decoder(original)
@@ -4,10 +4,17 @@
 from __future__ import annotations
 
 import json
+import logging
 
 import pytest
 
-from pikepdf import Job, JobUsageError, Pdf
+from pikepdf import (
+    CancellationToken,
+    Job,
+    JobUsageError,
+    OperationCancelledError,
+    Pdf,
+)
 
 
 def test_job_from_argv(resources):
@@ -56,6 +63,51 @@ def test_job_in_stages(resources, outpdf):
         assert len(pdf.pages) == 1
 
 
+def test_job_progress_only_for_one_run(resources, outpdf, capfd):
+    job_json = {}
+    job_json['inputFile'] = str(resources / 'outlines.pdf')
+    job_json['outputFile'] = str(outpdf)
+    job = Job(job_json)
+    events = []
+    job.run(progress_event=events.append)
+    assert events and events[-1].phase == 'job'
+
+    # Later runs neither report to the old callback nor print progress
+    count = len(events)
+    capfd.readouterr()
+    job.run()
+    assert len(events) == count
+    assert 'progress' not in capfd.readouterr().out
+
+
+def test_job_progress_keeps_configured_progress(resources, outpdf, caplog):
+    job = Job(['pikepdf', '--progress', str(resources / 'outlines.pdf'), str(outpdf)])
+    events = []
+    job.run(progress_event=events.append)
+    assert events
+
+    # A job configured with --progress goes back to logging its progress
+    caplog.clear()
+    caplog.set_level(logging.INFO)
+    job.run()
+    assert 'progress' in caplog.text
+
+
+def test_job_cancelled_while_running(resources, outpdf):
+    job_json = {}
+    job_json['inputFile'] = str(resources / 'outlines.pdf')
+    job_json['outputFile'] = str(outpdf)
+    job = Job(job_json)
+    token = CancellationToken()
+
+    def cancel_midway(event):
+        if event.percent >= 10:
+            token.cancel()
+
+    with pytest.raises(OperationCancelledError):
+        job.run(progress_event=cancel_midway, cancellation_token=token)
+
+
 def test_job_from_invalid_json():
     job_json = {}
     job_json['invalidJsonSetting'] = '123'
@@ -31,6 +31,7 @@ from pikepdf import (
     Object,
     Operator,
     Pdf,
+    PdfError,
     Stream,
     String,
 )
@@ -635,6 +636,67 @@ class TestStreamReadWrite:
         assert stream_object.read_bytes() == b'pointless'
         assert stream_object.read_raw_bytes() == double_compressed
 
+    def test_read_without_copy(self, stream_object):
+        stream_object.write(compress(b'def'), filter=Name.FlateDecode)
+        view = stream_object.read_bytes(copy=False)
+        assert isinstance(view, memoryview)
+        assert view.readonly
+        assert view == b'def'
+        with pytest.raises(TypeError):
+            view[0] = 0
+        raw = stream_object.read_raw_bytes(copy=False)
+        assert bytes(raw) == compress(b'def')
+        stream_object.write(b'replaced')
+        assert view == b'def'
+
+    def test_open_decoded(self, stream_object):
+        data = bytes(range(256)) * 1000
+        stream_object.write(compress(data), filter=Name.FlateDecode)
+        with stream_object.open_decoded(chunk_size=1000, max_chunks=2) as reader:
+            buffer = bytearray(300)
+            assert reader.readinto(buffer) == 300
+            assert buffer == data[:300]
+            assert reader.read() == data[300:]
+            assert reader.read() == b''
+
+    def test_open_decoded_detached(self, stream_object):
+        data = bytes(range(256)) * 1000
+        stream_object.write(compress(data), filter=Name.FlateDecode)
+        with stream_object.open_decoded(chunk_size=1000, max_chunks=1) as reader:
+            # The reader decodes its own copy, so the Pdf may be changed meanwhile
+            stream_object.write(b'replaced')
+            assert stream_object.read_bytes() == b'replaced'
+            assert reader.read() == data
+
+    def test_open_decoded_in_place(self):
+        # Indirect decode parameters need the Pdf, so are decoded when opened
+        with pikepdf.new() as pdf:
+            stream = Stream(pdf, b'')
+            stream.write(
+                compress(b'in place'),
+                filter=Name.FlateDecode,
+                decode_parms=Dictionary(Predictor=pdf.make_indirect(1)),
+            )
+            with stream.open_decoded() as reader:
+                stream.write(b'replaced')
+                assert reader.read() == b'in place'
+
+    def test_open_decoded_errors(self, stream_object):
+        with pytest.raises(TypeError):
+            Array([1]).open_decoded()
+
+        stream_object.write(b'not deflated', filter=Name.FlateDecode)
+        with stream_object.open_decoded() as reader, pytest.raises(PdfError):
+            reader.read()
+
+    def test_open_decoded_close_early(self, stream_object):
+        stream_object.write(compress(b'x' * 1_000_000), filter=Name.FlateDecode)
+        reader = stream_object.open_decoded(chunk_size=100, max_chunks=1)
+        assert reader.read(10) == b'x' * 10
+        reader.close()
+        with pytest.raises(ValueError):
+            reader.read(10)
+
     def test_explicit_decodeparms(self, stream_object):
         double_compressed = compress(compress(b'pointless'))
         stream_object.write(
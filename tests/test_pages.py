@@ -5,6 +5,7 @@ from __future__ import annotations
 
 import gc
 from contextlib import suppress
+from io import BytesIO
 from shutil import copy
 
 import pytest
@@ -548,3 +549,75 @@ def test_page_iteration(graph, fourpages):
     next(fourpages_iter)  # Discard
     graph.pages.extend(fourpages_iter)  # Append remaining two
     assert len(graph.pages) == 3
+
+
+@pytest.fixture
+def inherited_attrs_pdf(fourpages, tmp_path):
+    # Move page attributes up to the page tree root, where pages inherit them
+    pages_root = fourpages.Root.Pages
+    pages_root.MediaBox = fourpages.pages[0].MediaBox
+    pages_root.Rotate = 90
+    for page in fourpages.pages:
+        del page.obj.MediaBox
+        if Name.Rotate in page.obj:
+            del page.obj.Rotate
+    fourpages.save(tmp_path / 'inherited.pdf')
+    return tmp_path / 'inherited.pdf'
+
+
+def test_lazy_inherit_page_attributes(inherited_attrs_pdf):
+    with Pdf.open(inherited_attrs_pdf, inherit_page_attributes='lazy') as pdf:
+        # Reading pages does not change them
+        for page in pdf.pages:
+            assert Name.MediaBox not in page.obj
+            assert Name.Rotate not in page.obj
+        assert all(Name.MediaBox not in p for p in pdf._pages)
+
+        # Pages find inherited values
+        page = pdf.pages[1]
+        assert page.mediabox == pdf.Root.Pages.MediaBox
+        assert page.Rotate == page['/Rotate'] == page.get(Name.Rotate) == 90
+        assert Name.Rotate in page
+        assert Name.MediaBox not in page.obj
+
+        # Copying a page to another Pdf takes its inherited attributes with it
+        with Pdf.new() as other:
+            other.pages.append(pdf.pages[2])
+            assert other.pages[0].obj.MediaBox == pdf.Root.Pages.MediaBox
+            assert other.pages[0].obj.Rotate == 90
+
+
+def test_lazy_inherit_page_attributes_save(inherited_attrs_pdf):
+    with Pdf.open(inherited_attrs_pdf, inherit_page_attributes='lazy') as pdf:
+        _ = pdf.pages[1]
+        bio = BytesIO()
+        pdf.save(bio)
+        # Saving does not change the Pdf
+        assert all(Name.MediaBox not in p for p in pdf._pages)
+    with Pdf.open(bio, inherit_page_attributes=False) as saved:
+        # Only the page that was accessed is written with its inherited attributes
+        rotated = [Name.Rotate in p.obj for p in saved.pages]
+        assert rotated == [False, True, False, False]
+        assert saved.pages[1].obj.MediaBox == saved.Root.Pages.MediaBox
+
+
+def test_inherited_resources(inherited_attrs_pdf):
+    with Pdf.open(inherited_attrs_pdf, inherit_page_attributes='lazy') as pdf:
+        resources = pdf.pages[0].obj.Resources
+        pdf.Root.Pages.Resources = resources
+        del pdf.pages[0].obj.Resources
+        assert pdf.pages[0].resources == resources
+    with Pdf.open(inherited_attrs_pdf, inherit_page_attributes=False) as pdf:
+        # Without lazy page attributes, a page without resources gets empty ones
+        pdf.Root.Pages.Resources = pdf.pages[0].obj.Resources
+        del pdf.pages[0].obj.Resources
+        assert pdf.pages[0].resources == Dictionary()
+        assert Name.Rotate not in pdf.pages[0]
+
+
+def test_eager_and_no_inherit_page_attributes(inherited_attrs_pdf):
+    with Pdf.open(inherited_attrs_pdf) as pdf:
+        assert all(Name.MediaBox in p for p in pdf._pages)
+    with Pdf.open(inherited_attrs_pdf, inherit_page_attributes=False) as pdf:
+        assert Name.MediaBox not in pdf.pages[0].obj
+        assert pdf.pages[0].mediabox == pdf.Root.Pages.MediaBox
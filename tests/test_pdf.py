@@ -18,7 +18,7 @@ from unittest.mock import Mock
 import pytest
 
 import pikepdf
-from pikepdf import Name, PasswordError, Pdf, PdfError, Stream
+from pikepdf import Name, PasswordError, Pdf, PdfError, Stream, StreamDecodeLevel
 
 # pylint: disable=redefined-outer-name
 
@@ -190,6 +190,44 @@ class TestMemory:
             with pytest.raises(Exception):
                 Pdf.open(data)
 
+    @pytest.mark.parametrize('wrap', [bytes, bytearray, memoryview])
+    def test_buffer(self, resources, wrap):
+        data = wrap((resources / 'pal-1bit-trivial.pdf').read_bytes())
+        with Pdf.open(data, access_mode=pikepdf.AccessMode.buffer) as pdf:
+            assert pdf.Root.Pages.Count == 1
+            assert 'memory buffer' in pdf.filename
+
+    @pytest.mark.parametrize('wrap', [bytearray, memoryview])
+    def test_buffer_automatic(self, resources, wrap):
+        data = wrap((resources / 'pal-1bit-trivial.pdf').read_bytes())
+        with Pdf.open(data) as pdf:
+            assert pdf.Root.Pages.Count == 1
+
+    def test_buffer_keeps_source_alive(self, resources):
+        pdf = Pdf.open(bytearray((resources / 'fourpages.pdf').read_bytes()))
+        assert len(pdf.pages[3].Contents.read_bytes()) > 0
+        pdf.close()
+
+    def test_buffer_locks_bytearray(self, resources):
+        data = bytearray((resources / 'pal-1bit-trivial.pdf').read_bytes())
+        with Pdf.open(data):
+            with pytest.raises(BufferError):
+                data.extend(b'more')
+        data.extend(b'more')
+
+    def test_buffer_numpy(self, resources):
+        np = pytest.importorskip('numpy')
+        data = np.frombuffer(
+            (resources / 'pal-1bit-trivial.pdf').read_bytes(), dtype=np.uint8
+        )
+        with Pdf.open(data, access_mode=pikepdf.AccessMode.buffer) as pdf:
+            assert pdf.Root.Pages.Count == 1
+
+    def test_buffer_not_a_buffer(self):
+        # Not an int, which is rejected before the buffer is checked
+        with pytest.raises(TypeError):
+            Pdf.open(object(), access_mode=pikepdf.AccessMode.buffer)
+
 
 def test_remove_unreferenced(resources, outdir):
     in_ = resources / 'sandwich.pdf'
@@ -205,6 +243,95 @@ def test_remove_unreferenced(resources, outdir):
     assert out2.stat().st_size < out1.stat().st_size
 
 
+def test_deduplicate_streams(resources):
+    data = b'0 0 m 100 100 l S ' * 100
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        pdf.Root.Dupes = pdf.make_indirect(
+            [pdf.make_stream(data) for _ in range(3)] + [pdf.make_stream(b'other')]
+        )
+        dupes = pdf.Root.Dupes
+        result = pdf.deduplicate_streams()
+        assert result['duplicates'] == 2
+        assert result['bytes_saved'] == 2 * len(data)
+        assert dupes[0].objgen == dupes[1].objgen == dupes[2].objgen
+        assert dupes[3].objgen != dupes[0].objgen
+        assert pdf.deduplicate_streams()['duplicates'] == 0
+
+        bio = BytesIO()
+        pdf.save(bio)
+    with Pdf.open(bio) as pdf:
+        dupes = pdf.Root.Dupes
+        assert dupes[0].objgen == dupes[2].objgen
+        assert dupes[0].read_bytes() == data
+        assert dupes[3].read_bytes() == b'other'
+
+
+def test_deduplicate_streams_reduces_objects(resources):
+    def saved_object_count(pdf):
+        bio = BytesIO()
+        pdf.save(bio)
+        with Pdf.open(bio) as saved:
+            return len(saved.objects)
+
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        images = [pdf.make_stream(zlib.compress(b'\x00' * 300)) for _ in range(4)]
+        for image in images:
+            image.Filter = Name.FlateDecode
+        pdf.Root.Images = pdf.make_indirect(images)
+        before = saved_object_count(pdf)
+        assert pdf.deduplicate_streams()['duplicates'] == 3
+        assert saved_object_count(pdf) == before - 3
+
+
+def test_read_streams(resources):
+    data = b'0 0 m 100 100 l S ' * 100
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        good = pdf.make_stream(zlib.compress(data), Filter=Name.FlateDecode)
+        bad = pdf.make_stream(b'not deflated', Filter=Name.FlateDecode)
+        plain = pdf.make_stream(b'plain')
+        objects = [good, bad, pdf.Root, plain]
+        results = pdf.read_streams(objects, threads=2)
+        assert results[0] == data
+        assert isinstance(results[1], PdfError)
+        assert isinstance(results[2], TypeError)
+        assert results[3] == b'plain'
+        assert pdf.read_streams([]) == []
+
+        none = pdf.read_streams([good, plain], decode_level=StreamDecodeLevel.none)
+        assert isinstance(none[0], PdfError)
+        assert none[1] == b'plain'
+
+
+def test_decoded_stream_cache(resources):
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        assert pdf.decoded_stream_cache_stats is None
+        pdf.enable_decoded_stream_cache(max_bytes=1000)
+        small = pdf.make_stream(zlib.compress(b'small'), Filter=Name.FlateDecode)
+        large = pdf.make_stream(b'x' * 2000)
+
+        assert small.read_bytes() == b'small'
+        assert small.read_bytes() == b'small'
+        assert large.read_bytes() == b'x' * 2000
+        stats = pdf.decoded_stream_cache_stats
+        assert stats['hits'] == 1
+        assert stats['entries'] == 1
+        assert stats['bytes'] == len(b'small')
+        assert stats['max_bytes'] == 1000
+
+        small.write(b'changed')
+        assert small.read_bytes() == b'changed'
+        assert pdf.decoded_stream_cache_stats['hits'] == 1
+
+        other = pdf.make_stream(b'other')
+        assert other.read_bytes() == b'other'
+        pdf._swap_objects(small.objgen, other.objgen)
+        assert pdf.get_object(small.objgen).read_bytes() == b'other'
+        assert pdf.get_object(other.objgen).read_bytes() == b'changed'
+
+        pdf.disable_decoded_stream_cache()
+        assert pdf.decoded_stream_cache_stats is None
+
+
 def test_show_xref(trivial, caplog):
     with caplog.at_level(logging.INFO):
         trivial.show_xref_table()
@@ -380,6 +507,41 @@ def test_flate_compression_level():
         pikepdf.settings.set_flate_compression_level(-1)
 
 
+def test_invalid_flate_backend():
+    assert 'zlib' in pikepdf.settings.get_flate_backends()
+    with pytest.raises(ValueError):
+        pikepdf.settings.set_flate_backend('no such backend')
+    assert pikepdf.settings.get_flate_backend() == 'zlib'
+
+
+@pytest.mark.parametrize('backend', pikepdf.settings.get_flate_backends())
+def test_flate_backend(resources, backend):
+    data = b'flate backend test data ' * 1000
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+        pdf.Root.Extra = pdf.make_stream(data)
+        expected = BytesIO()
+        pdf.save(expected, static_id=True)
+    previous = pikepdf.settings.set_flate_backend(backend)
+    try:
+        assert pikepdf.settings.get_flate_backend() == backend
+        with Pdf.open(resources / 'graph.pdf') as pdf:
+            stream = Stream(pdf, zlib.compress(data))
+            stream.Filter = Name.FlateDecode
+            assert stream.read_bytes() == data
+            pdf.Root.Extra = pdf.make_stream(data)
+            bio = BytesIO()
+            pdf.save(bio, static_id=True)
+            # An ordinary save still compresses with zlib
+            assert bio.getvalue() == expected.getvalue()
+            bio = BytesIO()
+            pdf.save(bio, compress_threads=1)
+        with Pdf.open(bio) as pdf:
+            assert pdf.Root.Extra.Filter == Name.FlateDecode
+            assert pdf.Root.Extra.read_bytes() == data
+    finally:
+        pikepdf.settings.set_flate_backend(previous)
+
+
 def test_set_access_default_mmap():
     initial = pikepdf._core.get_access_default_mmap()
     try: